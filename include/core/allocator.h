@@ -6,6 +6,7 @@
 #endif
 #include <cstddef>
 #include <map>
+#include <set>
 namespace infini {
   class Allocator
   {
@@ -21,14 +22,25 @@ namespace infini {
     // pointer to the memory actually allocated
     void *ptr;
 
+    // size of the memory actually allocated, may exceed peak
+    size_t capacity;
+
+    // set once getPtr() has fixed the current plan
+    bool frozen;
+
     // =================================== 作业 ===================================
     // TODO：可能需要设计一个数据结构来存储free block，以便于管理和合并
     // HINT: 可以使用一个 map 来存储 free block，key 为 block 的起始/结尾地址，value 为 block 的大小
     // =================================== 作业 ===================================
     // key: free block start offset, value: free block size
     std::map<size_t, size_t> freeBlocks;
+    // The same free blocks ordered by (size, start offset) for best-fit search.
+    std::set<std::pair<size_t, size_t>> freeBlocksBySize;
   public:
-    Allocator(Runtime runtime);
+    // arguments:
+    //     alignment: every block is padded to and placed at a multiple of it,
+    //                the default covers a cache line and the widest SIMD loads
+    explicit Allocator(Runtime runtime, size_t alignment = 64);
 
     virtual ~Allocator();
 
@@ -44,15 +56,35 @@ namespace infini {
     //     size: size of memory block to be freed
     void free(size_t addr, size_t size);
 
-    // function: perform actual memory allocation
+    // function: perform actual memory allocation, reusing the existing arena
+    //           when the peak fits in it and growing it geometrically
+    //           otherwise
     // return: pointer to the head address of the allocated memory
     void *getPtr();
 
     void info();
 
+    // function: forget every simulated block so that a new plan can be
+    //           simulated, the arena is kept for reuse by the next getPtr()
+    void reset();
+
+    size_t getCapacity() const { return capacity; }
+
+    size_t getPeak() const { return peak; }
+
+    size_t getAlignment() const { return alignment; }
+
   private:
     // function: memory alignment, rouned up
     // return: size of the aligned memory block
     size_t getAlignedSize(size_t size);
+
+    // function: add a block to both free block indices
+    void insertFreeBlock(size_t addr, size_t size);
+
+    // function: remove a block from both free block indices
+    // return: iterator following the removed block in freeBlocks
+    std::map<size_t, size_t>::iterator
+    eraseFreeBlock(std::map<size_t, size_t>::iterator it);
   };
 }
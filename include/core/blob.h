@@ -11,9 +11,14 @@ class BlobObj
 {
   Runtime runtime;
   void *ptr;
+  // Keeps external backing storage (e.g. a file mapping) alive while the
+  // blob is in use. Empty for memory owned by an arena.
+  Ref<void> storage;
 
 public:
   BlobObj(Runtime runtime, void *ptr) : runtime(runtime), ptr(ptr) {}
+  BlobObj(Runtime runtime, void *ptr, Ref<void> storage)
+      : runtime(runtime), ptr(ptr), storage(std::move(storage)) {}
   BlobObj(BlobObj &other) = delete;
   BlobObj &operator=(BlobObj const &) = delete;
   ~BlobObj() {};
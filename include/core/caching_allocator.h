@@ -0,0 +1,102 @@
+#pragma once
+#include "core/common.h"
+#include <limits>
+#include <mutex>
+
+namespace infini
+{
+    /**
+     * @brief How arenas are mapped.
+     */
+    struct ArenaOptions
+    {
+        // Alignment of the returned pointer.
+        size_t alignment = 64;
+        // Back arenas of at least one huge page with huge pages: explicit
+        // MAP_HUGETLB pages when the system has them reserved, transparent
+        // huge pages otherwise.
+        bool hugePages = true;
+        // Fault in every page at allocation time instead of on first touch.
+        // Only applies to freshly mapped arenas; reused ones were touched by
+        // their previous owner.
+        bool prefault = false;
+        // Clear arenas reused from the cache. Fresh mappings are always zero.
+        bool zero = false;
+    };
+
+    /**
+     * @brief Process-wide cache of arenas shared by every runtime and graph.
+     *
+     * Released arenas are kept in size-class bins (four classes per power of
+     * two) and handed out again to requests of the same class and mapping
+     * options, so building graphs per request or per shape does not churn
+     * mmap/munmap and page faults. A reused arena keeps its previous contents
+     * unless ArenaOptions::zero is set. Cached arenas are unmapped whenever
+     * the reserved bytes (in use plus cached) exceed the memory ceiling.
+     */
+    class CachingAllocator
+    {
+    public:
+        struct Stats
+        {
+            size_t hits = 0;
+            size_t misses = 0;
+            // Bytes handed out and not yet released.
+            size_t inUseBytes = 0;
+            // Bytes of released arenas kept for reuse.
+            size_t cachedBytes = 0;
+            // Bytes unmapped to honor the ceiling or by trim().
+            size_t trimmedBytes = 0;
+        };
+
+    private:
+        struct Block
+        {
+            size_t sizeClass;
+            // Mapped bytes, at least the size class.
+            size_t length;
+            size_t alignment;
+            bool hugePages;
+        };
+        // (size class, alignment, huge pages) -> cached arenas
+        using BinKey = tuple<size_t, size_t, bool>;
+
+        std::mutex mutex;
+        std::map<BinKey, vector<void *>> bins;
+        std::unordered_map<void *, Block> blocks;
+        size_t ceiling = std::numeric_limits<size_t>::max();
+        Stats stats;
+
+        CachingAllocator() = default;
+
+    public:
+        static CachingAllocator &getInstance();
+
+        void *alloc(size_t size, const ArenaOptions &options);
+        void dealloc(void *ptr);
+
+        /**
+         * @brief Caps in-use plus cached bytes. Cached arenas are released to
+         * stay under it; arenas in use are never affected.
+         */
+        void setMemoryCeiling(size_t bytes);
+        size_t getMemoryCeiling();
+
+        /**
+         * @brief Releases cached arenas until at most `bytes` stay cached.
+         */
+        void trim(size_t bytes = 0);
+
+        Stats getStats();
+
+        /**
+         * @brief The size class serving a request of `size` bytes.
+         */
+        static size_t getSizeClass(size_t size);
+
+    private:
+        // Requires the mutex to be held.
+        void trimLocked(size_t cachedLimit);
+    };
+
+} // namespace infini
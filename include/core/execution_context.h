@@ -0,0 +1,105 @@
+#pragma once
+#include "core/graph.h"
+
+namespace infini
+{
+    class ExecutionContextObj;
+    using ExecutionContext = Ref<ExecutionContextObj>;
+
+    /**
+     * @brief Per-request execution state of a planned graph.
+     *
+     * A context owns its own activation arena, laid out with the offsets
+     * computed by GraphObj::dataMalloc, while the graph structure and the
+     * tensors bound on the graph (e.g. weights) are shared. Several contexts
+     * of the same graph can run concurrently on different threads.
+     *
+     * Kernels keep using TensorObj::getRawDataPtr: while a context is active
+     * on the calling thread, tensor data is resolved through its bindings.
+     */
+    class ExecutionContextObj : public Object
+    {
+    private:
+        Graph graph;
+        Runtime runtime;
+
+        // Context-owned arena with the same layout as the graph's plan.
+        void *arena;
+        size_t arenaSize;
+
+        // Tensors whose data is owned or supplied by this context. Tensors
+        // not bound here fall back to the data bound on the graph.
+        std::unordered_map<const TensorObj *, void *> bindings;
+
+    public:
+        /**
+         * @brief Makes the bindings of a context visible to TensorObj on the
+         * current thread for the lifetime of the scope.
+         */
+        class ActiveScope
+        {
+            const ExecutionContextObj *previous;
+
+        public:
+            explicit ActiveScope(const ExecutionContextObj &context);
+            ~ActiveScope();
+            ActiveScope(const ActiveScope &) = delete;
+            ActiveScope &operator=(const ActiveScope &) = delete;
+        };
+
+        /**
+         * @brief Creates a context for a graph on which dataMalloc has been
+         * called. Every tensor produced by an operator gets its own storage.
+         */
+        explicit ExecutionContextObj(Graph graph);
+        ~ExecutionContextObj();
+        ExecutionContextObj(const ExecutionContextObj &) = delete;
+        ExecutionContextObj &operator=(const ExecutionContextObj &) = delete;
+
+        string toString() const override;
+        Graph getGraph() const { return graph; }
+
+        /**
+         * @brief Binds a graph input to a caller-owned buffer. The buffer must
+         * stay valid while the context runs.
+         */
+        void bindInput(const Tensor &tensor, void *ptr);
+
+        /**
+         * @brief Fills a context-private copy of a graph input.
+         */
+        void setInput(
+            const Tensor &tensor,
+            std::function<void(void *, size_t, DataType)> const &generator);
+
+        /**
+         * @brief Runs the graph with this context's bindings.
+         */
+        void run();
+
+        /**
+         * @brief Returns the storage of a tensor as seen by this context.
+         */
+        template <typename T>
+        T getRawDataPtr(const Tensor &tensor) const
+        {
+            static_assert(std::is_pointer_v<T>,
+                          "Raw data pointer has a type of pointer");
+            if (auto ptr = lookup(tensor.get()))
+                return reinterpret_cast<T>(ptr);
+            return tensor->getRawDataPtr<T>();
+        }
+
+        /**
+         * @brief Returns the context-local storage of a tensor, or nullptr if
+         * the tensor resolves to the data bound on the graph.
+         */
+        void *lookup(const TensorObj *tensor) const;
+
+        /**
+         * @brief The context active on the calling thread, if any.
+         */
+        static const ExecutionContextObj *current();
+    };
+
+} // namespace infini
@@ -1,7 +1,11 @@
 #pragma once
 #include "core/allocator.h"
+#include "core/memory_planner.h"
+#include "core/node_arena.h"
+#include "core/offload.h"
 #include "core/operator.h"
 #include "core/tensor.h"
+#include "core/weight_region.h"
 #include <algorithm>
 #include <cstdint>
 
@@ -10,34 +14,80 @@ namespace infini
 
     class GraphObj : public Object
     {
+        friend class GraphRewriter;
+
     protected:
         Runtime runtime;
         TensorVec tensors;
         OpVec ops;
         Allocator allocator;
+        // Storage of weight tensors, kept across re-planning.
+        WeightRegion weightRegion;
+        // Plan chosen by the last dataMalloc.
+        MemoryPlan memoryPlan;
+        // Plans computed so far, keyed by the shapes of the graph inputs.
+        std::map<vector<Shape>, MemoryPlan> planCache;
+        // Plan compiled from the first plan computed with symbolic shapes,
+        // evaluated on misses of the plan cache after bindDims.
+        optional<SymbolicPlan> symbolicPlan;
+        // Set by bindDims while the shapes follow from it.
+        optional<SymBindings> dimBindings;
+        // If the ops are in the order of reorderForMemory since the graph or
+        // the planning options last changed.
+        bool memoryOrdered = false;
+        // Arena offset of every tensor placed by dataMalloc.
+        std::unordered_map<const TensorObj *, size_t> tensorOffsets;
+        // Maximum number of ops executed at once.
+        int parallelism = 1;
+        // Stage i runs ops[stages[i]] to ops[stages[i + 1] - 1].
+        vector<size_t> stages;
+        // Upper bound on the arena size, 0 if unbounded.
+        size_t memoryBudget = 0;
+        // Outputs declared by the caller, empty if not declared.
+        TensorVec outputs;
+        std::unordered_set<const TensorObj *> outputSet;
+        // Positions of the tensors (by fuid) and ops in `tensors` and `ops`.
+        // Entries are hints checked on use, and the index is rebuilt when one
+        // is stale, so passes may edit the vectors directly.
+        mutable std::unordered_map<UidBaseType, size_t> tensorIndex;
+        mutable std::unordered_map<const OperatorObj *, size_t> opIndex;
+        // Guids of ops placed late to recompute a tensor for later uses.
+        std::unordered_set<UidBaseType> recomputeOps;
+        // Shapes of the tensors without a producer at the last shape_infer,
+        // empty if it must visit every op.
+        vector<pair<Tensor, Shape>> inferredInputShapes;
+        // Set in NodeStorage::Arena mode.
+        NodeArena nodeArena;
+        // Set if idle activations are moved to a scratch file.
+        optional<OffloadOptions> offloadOptions;
+        Offloader offloader;
 
     public:
-        explicit GraphObj(Runtime runtime)
-            : runtime(runtime), allocator(runtime), sorted(false){};
+        explicit GraphObj(Runtime runtime,
+                          NodeStorage storage = NodeStorage::Heap)
+            : runtime(runtime), allocator(runtime),
+              nodeArena(storage == NodeStorage::Arena
+                            ? make_ref<NodeArenaObj>()
+                            : nullptr),
+              sorted(false){};
+        /**
+         * @brief Detaches the ops of the graph from their inputs and from
+         * each other, so tensors and ops that outlive it hold no edges to
+         * destroyed ops.
+         */
+        ~GraphObj();
         string toString() const override;
         Runtime getRuntime() const { return runtime; }
 
         Tensor addTensor(Shape dim, DataType dtype = DataType::Float32);
         Tensor addTensor(const Tensor &tensor);
         TensorVec addTensor(const TensorVec &tensors);
-        void removeOperator(Operator op)
-        {
-            auto it = std::find(ops.begin(), ops.end(), op);
-            if (it != ops.end())
-                ops.erase(it);
-        }
-
-        void removeTensor(Tensor tensor)
-        {
-            auto it = std::find(tensors.begin(), tensors.end(), tensor);
-            if (it != tensors.end())
-                tensors.erase(it);
-        }
+        /**
+         * @brief Removes `op`, dropping it from the targets of its inputs and
+         * from the edges of its predecessors and successors.
+         */
+        void removeOperator(Operator op);
+        void removeTensor(Tensor tensor);
 
         const TensorVec &getTensors() const { return tensors; }
         const OpVec &getOperators() const { return ops; }
@@ -51,12 +101,196 @@ namespace infini
          */
         bool topo_sort();
 
+        /**
+         * @brief Reorders the sorted ops to lower the peak of live activation
+         * bytes, which the memory plan cannot go below.
+         *
+         * Ops are emitted depth-first from the graph sinks, and the producers
+         * of each op are visited in decreasing order of the memory their
+         * subgraph needs, so that the large branches complete before the
+         * results of the small ones are held. Recomputing ops stay right
+         * before their first consumer. The current order is kept unless the
+         * new one has a lower peak. dataMalloc calls it after the graph
+         * changes.
+         * Returns if the order changed.
+         */
+        bool reorderForMemory();
+
+        /**
+         * @brief Removes dead code, applies the registered rewrite rules,
+         * merges common subexpressions and folds constants.
+         */
         void optimize();
 
-        void shape_infer();
+        /**
+         * @brief Removes the ops and tensors that the declared outputs do not
+         * depend on. Returns if the graph changed.
+         */
+        bool eliminateDeadCode();
 
+        /**
+         * @brief Merges ops of the same type and attributes that consume the
+         * same tensors, rewiring the consumers of the duplicates to the
+         * outputs of the first one. Returns if the graph changed.
+         */
+        bool eliminateCommonSubexpressions();
+
+        /**
+         * @brief Evaluates ops whose inputs are all weights with data once,
+         * using the registered kernels, and replaces their outputs by new
+         * weight tensors. Weights left without consumers are dropped. Call
+         * it after the weights are loaded. If the graph has a weight region,
+         * it is rebuilt to hold the folded constants and drop the dead
+         * weights. Returns if the graph changed.
+         */
+        bool foldConstants();
+
+        /**
+         * @brief Infers the shapes of the op outputs after tensors without a
+         * producer (inputs and weights) changed shape. Only the ops
+         * downstream of changed tensors are visited, stopping at ops whose
+         * output shapes stay the same; the first call, and the first one
+         * after ops are added or removed, visits every op. Returns the number
+         * of ops visited.
+         */
+        size_t shape_infer();
+
+        /**
+         * @brief Derives the symbolic shape of every op output from the
+         * symbolic shapes set on the inputs (TensorObj::setSymbolicShape).
+         * Tensors without one have constant dims. Fails if an op cannot infer
+         * its outputs symbolically.
+         */
+        void inferSymbolicShapes();
+
+        /**
+         * @brief Sets every tensor shape by evaluating its symbolic shape,
+         * instead of shape_infer. The following dataMalloc evaluates the
+         * compiled symbolic plan rather than planning from scratch.
+         */
+        void bindDims(const SymBindings &bindings);
+
+        /**
+         * @brief Binds weights to the weight region and plans every other
+         * tensor into the activation arena.
+         *
+         * It can be called again after input shapes change and shape_infer:
+         * only activations are re-planned. Plans are cached per input-shape
+         * signature, and the arena is reused while the new peak fits in it.
+         * Execution contexts created before a re-plan must be recreated.
+         */
         void dataMalloc();
 
+        /**
+         * @brief Number of distinct input-shape signatures planned so far.
+         */
+        size_t getPlanCacheSize() const { return planCache.size(); }
+
+        const WeightRegion &getWeightRegion() const { return weightRegion; }
+
+        /**
+         * @brief Uses the weights of another graph of the same model. Its
+         * weight tensors must be clones of the ones in this graph.
+         */
+        void setWeightRegion(const WeightRegion &region);
+
+        /**
+         * @brief Lets up to `parallelism` independent ops run at once.
+         *
+         * dataMalloc then groups ops into stages of mutually independent ops,
+         * separated by barriers, and plans lifetimes over stages instead of
+         * single ops: a tensor is freed only after the stage of its last
+         * consumer, so tensors share memory only if one dies in a stage that
+         * completes before the other's producer starts.
+         */
+        void setParallelism(int parallelism);
+        int getParallelism() const { return parallelism; }
+
+        /**
+         * @brief Caps the activation arena at `bytes` (0 for no cap).
+         *
+         * When a plan exceeds the budget, dataMalloc frees cheap-to-recompute
+         * tensors (element-wise, unary, Cast and Transpose outputs) across the
+         * peak step and recomputes them right before their later uses,
+         * preferring tensors that free the most bytes for the longest span at
+         * the lowest recompute time, as predicted from OperatorObj::getCost by
+         * the runtime's machine model. The recomputing ops stay in the graph.
+         * It fails, leaving the graph as it was, if the budget still cannot be
+         * met.
+         */
+        void setMemoryBudget(size_t bytes);
+        size_t getMemoryBudget() const { return memoryBudget; }
+
+        /**
+         * @brief Enables (or with nullopt disables) offloading.
+         *
+         * Computed tensors of at least `minBytes` that stay unused for at least
+         * `minIdleSteps` steps then occupy the arena only while in use: they
+         * are written to a memory-mapped scratch file and read back
+         * asynchronously ahead of their next use. Meant for throughput jobs
+         * whose arena exceeds physical memory. Execution contexts cannot be
+         * used with it.
+         */
+        void setOffloadOptions(optional<OffloadOptions> options);
+
+        /**
+         * @brief Moves offloaded tensors while the graph runs. Empty if no
+         * tensor is offloaded by the last dataMalloc.
+         */
+        const Offloader &getOffloader() const { return offloader; }
+
+        /**
+         * @brief Stage boundaries of the last dataMalloc: stage i runs
+         * ops[stages[i]] to ops[stages[i + 1] - 1] concurrently.
+         */
+        const vector<size_t> &getStages() const { return stages; }
+
+        /**
+         * @brief Builds the lifetime interval of every non-weight tensor over
+         * the execution stages and keeps the smallest plan over all planner
+         * strategies.
+         */
+        MemoryPlan planMemory() const;
+
+        const MemoryPlan &getMemoryPlan() const { return memoryPlan; }
+
+        /**
+         * @brief Placement, lifetime and live bytes per step of the plan used
+         * by the last dataMalloc.
+         */
+        MemoryPlanReport getMemoryReport() const;
+
+        /**
+         * @brief Offsets assigned by the last dataMalloc, keyed by tensor.
+         */
+        const std::unordered_map<const TensorObj *, size_t> &
+        getTensorOffsets() const
+        {
+            return tensorOffsets;
+        }
+
+        /**
+         * @brief Size in bytes of the arena required by the memory plan.
+         */
+        size_t getArenaSize() const { return memoryPlan.peak; }
+
+        /**
+         * @brief Arena holding the nodes, nullptr in NodeStorage::Heap mode.
+         */
+        const NodeArena &getNodeArena() const { return nodeArena; }
+
+        /**
+         * @brief Allocates a tensor or op in the storage of this graph.
+         */
+        template <typename T, typename... Args>
+        Ref<T> makeNode(Args &&...args)
+        {
+            if (nodeArena)
+                return std::allocate_shared<T>(NodeAllocator<T>(nodeArena),
+                                               std::forward<Args>(args)...);
+            return infini::make_ref<T>(std::forward<Args>(args)...);
+        }
+
         /**
          * @brief Add an operator and create its outputs. Output tensor arguments
          * should be empty Refs (e.g., nullptr).
@@ -64,7 +298,7 @@ namespace infini
         template <typename T, typename... Args>
         Ref<T> addOp(Args &&...args)
         {
-            Ref<T> op = infini::make_ref<T>(this, std::forward<Args>(args)...);
+            Ref<T> op = makeNode<T>(this, std::forward<Args>(args)...);
             addOperatorAndConnect(op);
             return op;
         }
@@ -75,7 +309,7 @@ namespace infini
         template <typename T, typename... Args>
         Ref<T> addOpWithOutputs(Args &&...args)
         {
-            Ref<T> op = infini::make_ref<T>(nullptr, std::forward<Args>(args)...);
+            Ref<T> op = makeNode<T>(nullptr, std::forward<Args>(args)...);
             addOperatorAndConnect(op);
             return op;
         }
@@ -93,25 +327,131 @@ namespace infini
         }
 
         /**
-         * @brief Gets output tensors of this graph.
+         * @brief Gets output tensors of this graph: the declared ones, or
+         * else every tensor without consumers.
          */
         inline TensorVec getOutputs() const
         {
+            if (!outputs.empty())
+                return outputs;
             TensorVec ret;
             for (const auto &t : tensors)
-                if (t->getTargets().empty())
+                if (t->getTargetView().empty())
                     ret.emplace_back(t);
             return ret;
         }
 
+        /**
+         * @brief Declares the tensors the caller reads after a run. Others
+         * without consumers are no longer outputs.
+         */
+        void setOutputs(const TensorVec &outputs);
+
+        bool isOutput(const Tensor &tensor) const
+        {
+            if (outputs.empty())
+                return tensor->getTargetView().empty();
+            return outputSet.count(tensor.get()) > 0;
+        }
+
         bool checkValid() const;
 
     private:
+        /**
+         * @brief Position of a tensor in `tensors`, or nullopt if it is not in
+         * the graph.
+         */
+        optional<size_t> findTensor(UidBaseType fuid) const;
+
+        /**
+         * @brief Position of an op in `ops`, or nullopt if it is not in the
+         * graph.
+         */
+        optional<size_t> findOperator(const OperatorObj *op) const;
+
+        /**
+         * @brief Maximum live bytes of the tensors computed by the ops, run in
+         * the given order one at a time.
+         */
+        size_t getPeakLiveBytes(const OpVec &order) const;
+
+        /**
+         * @brief Drops the plans computed for the current graph and options.
+         */
+        void invalidatePlans();
+
+        /**
+         * @brief Compiles `plan` into a symbolic plan if the symbolic shapes
+         * of its tensors are known.
+         */
+        optional<SymbolicPlan> compileSymbolicPlan(const MemoryPlan &plan) const;
+
+        /**
+         * @brief Shapes of the non-weight graph inputs, which determine every
+         * other shape and thereby the memory plan.
+         */
+        vector<Shape> getInputSignature() const;
+
+        /**
+         * @brief Binds weights without data to the weight region, creating the
+         * region on first use and rebuilding it when weights it does not hold
+         * were added.
+         */
+        void bindWeights();
+
+        /**
+         * @brief Replaces the weight region by a new one laid out for
+         * `weights`, moving their data into it, either their own or the one
+         * held for their family by the current region.
+         */
+        void rebuildWeightRegion(const TensorVec &weights);
+
+        /**
+         * @brief Reorders the sorted ops stage by stage. Ops of a stage
+         * depend only on ops of earlier stages.
+         */
+        void schedule();
+
+        /**
+         * @brief Stage of every op under the current schedule.
+         */
+        std::unordered_map<const OperatorObj *, int> getOpStages() const;
+
+        /**
+         * @brief Recomputes tensors until `plan` fits in the memory budget and
+         * returns the plan of the rewritten graph.
+         */
+        MemoryPlan rematerialize(MemoryPlan plan);
+
+        /**
+         * @brief Builds the offloader of the tensors split into several
+         * intervals by the memory plan.
+         */
+        Offloader makeOffloader(void *base) const;
+
+        /**
+         * @brief Frees the best candidate tensor live across `peakStep` by
+         * recomputing it for its uses after that step. Returns the recomputing
+         * op and the freed tensor, or nullptrs if there is no candidate.
+         */
+        pair<Operator, Tensor> recomputeAcross(int peakStep);
+
+        /**
+         * @brief Reverts recomputeAcross: the consumers of the recomputing
+         * op read `original` again, and the op and its output are removed.
+         */
+        void undoRecompute(const Operator &recompute, const Tensor &original);
+
         /**
          * @brief Add reverse connections and Op relationship in ctor.
          */
         void addOperatorAndConnect(const Operator &op);
 
+        /**
+         * @brief Links an op to the producers and consumers of its tensors.
+         */
+        void connect(const Operator &op);
+
         /**
          * @brief If the nodes is sorted in topological order.
          */
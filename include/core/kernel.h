@@ -51,6 +51,10 @@ namespace infini
             kernels.emplace(key, KernelRecord{kernel, name, ++nKernels});
             return true;
         }
+        bool hasKernel(const KernelAttrs &kernelAttrs) const
+        {
+            return kernels.find(kernelAttrs) != kernels.end();
+        }
         Kernel *getKernel(const KernelAttrs &kernelAttrs) const
         {
             auto it = kernels.find(kernelAttrs);
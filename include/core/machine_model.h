@@ -0,0 +1,73 @@
+#pragma once
+#include "core/common.h"
+#include "core/op_cost.h"
+
+namespace infini
+{
+    /**
+     * @brief Per-machine constants used to size intra-op parallelism.
+     *
+     * The serial time of an op is the roofline prediction from its OpCost,
+     * bound by either the memory bandwidth or the arithmetic throughput. On
+     * `p` threads it becomes
+     *   serial / p + (p > 1 ? forkJoinNs * p / maxThreads : 0)
+     * and the runtime runs each kernel with the `p` minimizing it, so tiny
+     * tensors stay serial and large ones use every thread. Passes comparing
+     * ops or rewrites use the same prediction.
+     */
+    class MachineModel
+    {
+    public:
+        // Threads available to a parallel region.
+        int maxThreads = 1;
+        // Cost of forking and joining a team of maxThreads threads.
+        double forkJoinNs = 0;
+        // Serial streaming bandwidth out of the last-level cache.
+        double bytesPerNs = 8;
+        // Serial arithmetic throughput of independent multiply-adds.
+        double flopsPerNs = 4;
+
+        /**
+         * @brief Predicted time of an op of the given cost on `threads`
+         * threads, including the fork-join overhead.
+         */
+        double predictNs(const OpCost &cost, int threads = 1) const;
+
+        /**
+         * @brief Thread count minimizing predictNs of `cost`.
+         */
+        int threadsFor(const OpCost &cost) const;
+
+        /**
+         * @brief Measures the constants of the current machine.
+         */
+        static MachineModel calibrate();
+
+        /**
+         * @brief Loads the model stored at `path`, or calibrates and stores it
+         * there if the file does not exist. An empty path calibrates without
+         * storing.
+         */
+        static MachineModel loadOrCalibrate(const string &path);
+
+        /**
+         * @brief loadOrCalibrate with getDefaultPath(). A stored model with
+         * another thread count than the current one is recalibrated.
+         */
+        static MachineModel loadOrCalibrate();
+
+        /**
+         * @brief The INFINI_MACHINE_MODEL environment variable if set, else
+         * infinitensor/machine_model.txt under $XDG_CACHE_HOME or
+         * $HOME/.cache. Empty, so nothing is stored, if none of them is set
+         * or INFINI_MACHINE_MODEL is set to an empty string.
+         */
+        static string getDefaultPath();
+
+        bool save(const string &path) const;
+        static optional<MachineModel> load(const string &path);
+
+        string toString() const;
+    };
+
+} // namespace infini
@@ -0,0 +1,207 @@
+#pragma once
+#include "core/symbolic.h"
+#include "core/tensor.h"
+
+namespace infini
+{
+    /**
+     * @brief A buffer that must stay resident from step `begin` to step `end`
+     * (both inclusive) of an execution schedule.
+     */
+    struct LiveInterval
+    {
+        Tensor tensor;
+        size_t bytes;
+        int begin;
+        int end;
+
+        bool overlaps(const LiveInterval &rhs) const
+        {
+            return begin <= rhs.end && rhs.begin <= end;
+        }
+    };
+
+    enum class PlanStrategy
+    {
+        // Replays alloc/free events in step order through Allocator.
+        OnlineBestFit,
+        // Places the largest buffers first.
+        GreedyBySize,
+        // Places the buffers of the most crowded steps first.
+        GreedyByBreadth,
+        // Places buffers in step order, largest first within a window of
+        // upcoming steps.
+        BestFitLookahead,
+    };
+
+    const char *toString(PlanStrategy strategy);
+
+    /**
+     * @brief Offsets assigned to a set of live intervals.
+     */
+    struct MemoryPlan
+    {
+        PlanStrategy strategy = PlanStrategy::OnlineBestFit;
+        vector<LiveInterval> intervals;
+        // offsets[i] is the arena offset of intervals[i].
+        vector<size_t> offsets;
+        // Arena size required by the plan.
+        size_t peak = 0;
+        // Maximum live bytes at any step. No plan can be smaller.
+        size_t lowerBound = 0;
+
+        /**
+         * @brief Relative distance of the plan from the lower bound.
+         */
+        double gap() const
+        {
+            return lowerBound == 0 ? 0.
+                                   : double(peak - lowerBound) / lowerBound;
+        }
+
+        string toString() const;
+    };
+
+    /**
+     * @brief A memory plan whose buffer sizes are expressions of dimension
+     * variables. With n intervals and p overlapping pairs among them, it is
+     * built in O(n log steps + p) and evaluated per binding in O(n + p).
+     *
+     * It keeps the relative placement of a reference plan: intervals are
+     * stacked in the order of their reference offsets, each right above the
+     * overlapping intervals placed below it. The result never overlaps for
+     * any binding and matches the reference at the binding it was planned
+     * for; bindings far from it may leave more gaps than a fresh plan.
+     */
+    class SymbolicPlan
+    {
+        size_t alignment;
+        PlanStrategy strategy;
+        vector<LiveInterval> intervals;
+        // sizes[i] is the unaligned byte size of intervals[i].
+        vector<SymExpr> sizes;
+        // Intervals by reference offset, and for each the overlapping ones
+        // earlier in that order.
+        vector<size_t> order;
+        vector<vector<size_t>> below;
+
+    public:
+        SymbolicPlan(const MemoryPlan &reference, vector<SymExpr> sizes,
+                     size_t alignment = 64);
+
+        MemoryPlan evaluate(const SymBindings &bindings) const;
+    };
+
+    /**
+     * @brief Where a tensor lives in the arena and for which ops.
+     */
+    struct TensorPlacement
+    {
+        UidBaseType guid;
+        UidBaseType fuid;
+        DataType dtype;
+        Shape dims;
+        size_t offset;
+        // Aligned bytes reserved in the arena.
+        size_t bytes;
+        // Steps (op indices in execution order), both inclusive.
+        int firstOp;
+        int lastOp;
+    };
+
+    /**
+     * @brief Structured view of a memory plan, for finding out why a model
+     * needs the memory it does and which tensors to target.
+     */
+    struct MemoryPlanReport
+    {
+        PlanStrategy strategy = PlanStrategy::OnlineBestFit;
+        vector<TensorPlacement> tensors;
+        // ops[i] names the op executed at step i.
+        vector<string> ops;
+        // liveBytes[i] is the bytes resident while step i executes.
+        vector<size_t> liveBytes;
+        int peakStep = -1;
+        size_t arenaSize = 0;
+
+        size_t getPeakLiveBytes() const
+        {
+            return peakStep < 0 ? 0 : liveBytes[peakStep];
+        }
+
+        /**
+         * @brief Fraction of the arena not used by live tensors at the peak
+         * step. Zero means the plan cannot be improved by re-placement.
+         */
+        double getFragmentation() const
+        {
+            return arenaSize == 0 ? 0.
+                                  : 1. - double(getPeakLiveBytes()) / arenaSize;
+        }
+
+        string toJson() const;
+
+        /**
+         * @brief One row per tensor.
+         */
+        string toCsv() const;
+    };
+
+    /**
+     * @brief Builds the report of `plan` over `numSteps` steps. Ops are left
+     * unnamed.
+     */
+    MemoryPlanReport makeReport(const MemoryPlan &plan, int numSteps);
+
+    /**
+     * @brief Offline memory planner over known tensor lifetimes. Two
+     * intervals may share memory only if their lifetimes are disjoint.
+     */
+    class MemoryPlanner
+    {
+    private:
+        size_t alignment;
+        // Window of steps considered by BestFitLookahead.
+        int lookahead;
+        vector<LiveInterval> intervals;
+
+    public:
+        explicit MemoryPlanner(size_t alignment = 64,
+                               int lookahead = 4);
+
+        /**
+         * @brief Adds a buffer of `bytes` live over [begin, end].
+         */
+        void addInterval(const Tensor &tensor, size_t bytes, int begin,
+                         int end);
+
+        const vector<LiveInterval> &getIntervals() const { return intervals; }
+
+        /**
+         * @brief Maximum live bytes over all steps.
+         */
+        size_t lowerBound() const;
+
+        MemoryPlan solve(PlanStrategy strategy) const;
+
+        /**
+         * @brief Solves with every given strategy and keeps the plan with the
+         * smallest peak.
+         */
+        MemoryPlan solve(const vector<PlanStrategy> &strategies) const;
+
+        static const vector<PlanStrategy> &allStrategies();
+
+    private:
+        size_t getAlignedSize(size_t size) const;
+
+        /**
+         * @brief Places intervals in the given order, each into the smallest
+         * gap left by already placed intervals that overlap it in time.
+         */
+        vector<size_t> placeInOrder(const vector<size_t> &order) const;
+
+        vector<size_t> replayOnline() const;
+    };
+
+} // namespace infini
@@ -0,0 +1,84 @@
+#pragma once
+#include "core/common.h"
+#include "core/ref.h"
+
+namespace infini
+{
+    /**
+     * @brief Where a graph allocates its tensors and ops.
+     */
+    enum class NodeStorage
+    {
+        // One heap allocation per node.
+        Heap,
+        // Nodes are packed into chunks owned by a NodeArenaObj.
+        Arena,
+    };
+
+    /**
+     * @brief Bump allocator for graph nodes.
+     *
+     * Memory is carved out of large chunks and only returned when the arena
+     * is destroyed, which happens after the last node allocated from it.
+     * Nodes removed from a graph keep their space until then. It is not
+     * thread-safe, like graph construction.
+     */
+    class NodeArenaObj
+    {
+        vector<void *> chunks;
+        char *cursor = nullptr;
+        char *limit = nullptr;
+        size_t chunkSize;
+        size_t allocatedBytes = 0;
+
+    public:
+        explicit NodeArenaObj(size_t chunkSize = 2 * 1024 * 1024)
+            : chunkSize(chunkSize) {}
+        NodeArenaObj(const NodeArenaObj &) = delete;
+        NodeArenaObj &operator=(const NodeArenaObj &) = delete;
+        ~NodeArenaObj();
+
+        void *allocate(size_t bytes, size_t alignment);
+
+        /**
+         * @brief Bytes handed out so far, including alignment padding.
+         */
+        size_t getAllocatedBytes() const { return allocatedBytes; }
+        size_t getNumChunks() const { return chunks.size(); }
+    };
+    using NodeArena = Ref<NodeArenaObj>;
+
+    /**
+     * @brief Standard allocator over a NodeArenaObj, for std::allocate_shared.
+     * Every control block holds a copy, which keeps the arena alive.
+     */
+    template <typename T>
+    class NodeAllocator
+    {
+    public:
+        using value_type = T;
+        NodeArena arena;
+
+        explicit NodeAllocator(NodeArena arena) : arena(std::move(arena)) {}
+        template <typename U>
+        NodeAllocator(const NodeAllocator<U> &other) : arena(other.arena) {}
+
+        T *allocate(size_t n)
+        {
+            return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+        }
+        void deallocate(T *, size_t) {}
+
+        template <typename U>
+        bool operator==(const NodeAllocator<U> &other) const
+        {
+            return arena == other.arena;
+        }
+        template <typename U>
+        bool operator!=(const NodeAllocator<U> &other) const
+        {
+            return arena != other.arena;
+        }
+    };
+
+} // namespace infini
@@ -0,0 +1,95 @@
+#pragma once
+#include "core/tensor.h"
+#include <future>
+
+namespace infini
+{
+    class OffloaderObj;
+    using Offloader = Ref<OffloaderObj>;
+
+    /**
+     * @brief When GraphObj moves idle activations out of the arena.
+     */
+    struct OffloadOptions
+    {
+        // Directory of the scratch file.
+        string directory = "/tmp";
+        // Tensors smaller than this stay in the arena.
+        size_t minBytes = size_t(1) << 20;
+        // Only idle spans of at least this many steps are offloaded.
+        int minIdleSteps = 4;
+        // Steps ahead of a use at which the tensor is read back. 0 derives it
+        // from the schedule: a quarter of the idle span.
+        int prefetchSteps = 0;
+    };
+
+    /**
+     * @brief Moves tensors between the arena and a memory-mapped scratch file
+     * while a graph runs.
+     *
+     * A tensor offloaded across an idle span has one arena slot per resident
+     * span (segment). After the last step of a segment its data is written to
+     * the scratch file, and ahead of the next use it is read back into the
+     * next segment's slot by an asynchronous copy, which is awaited before
+     * the step using it. The runtime calls beforeStep/afterStep around every
+     * step of the schedule.
+     */
+    class OffloaderObj
+    {
+    public:
+        struct Segment
+        {
+            void *ptr;
+            // Steps during which the slot is reserved, both inclusive.
+            int begin;
+            int end;
+            // First step in the segment using the data.
+            int firstUse;
+        };
+
+    private:
+        struct Entry
+        {
+            Tensor tensor;
+            vector<Segment> segments;
+            vector<Blob> blobs;
+            size_t fileOffset;
+            // If the scratch file holds the data of the current run.
+            bool written;
+        };
+        // (entry, segment) pairs keyed by step.
+        using Events = std::unordered_map<int, vector<pair<size_t, size_t>>>;
+
+        vector<Entry> entries;
+        Events evictions, prefetches, waits;
+        std::unordered_map<size_t, std::future<void>> pending;
+        void *file;
+        size_t fileSize;
+
+    public:
+        /**
+         * @brief Creates the scratch file for `tensors`, whose segments are
+         * sorted by time.
+         */
+        OffloaderObj(Runtime runtime, const OffloadOptions &options,
+                     vector<pair<Tensor, vector<Segment>>> tensors);
+        ~OffloaderObj();
+        OffloaderObj(const OffloaderObj &) = delete;
+        OffloaderObj &operator=(const OffloaderObj &) = delete;
+
+        void beforeStep(int step);
+        void afterStep(int step);
+
+        size_t getNumTensors() const { return entries.size(); }
+        size_t getScratchSize() const { return fileSize; }
+
+        /**
+         * @brief Splits the lifetime [begin, end] of a tensor touched at the
+         * sorted steps `uses` into resident segments.
+         */
+        static vector<pair<int, int>> split(const OffloadOptions &options,
+                                            int begin, int end,
+                                            const vector<int> &uses);
+    };
+
+} // namespace infini
@@ -0,0 +1,39 @@
+#pragma once
+#include "core/common.h"
+
+namespace infini
+{
+    /**
+     * @brief Work of one op execution, derived from its shapes and data types.
+     * MachineModel::predictNs turns it into a time.
+     */
+    struct OpCost
+    {
+        // Arithmetic operations, counting a multiply-add as two.
+        size_t flops = 0;
+        size_t bytesRead = 0;
+        size_t bytesWritten = 0;
+
+        size_t getBytes() const { return bytesRead + bytesWritten; }
+
+        /**
+         * @brief Flops per byte moved. Ops below the machine balance
+         * (MachineModel::flopsPerNs / bytesPerNs) are memory bound.
+         */
+        double getArithmeticIntensity() const
+        {
+            return getBytes() == 0 ? 0. : double(flops) / getBytes();
+        }
+
+        OpCost &operator+=(const OpCost &rhs)
+        {
+            flops += rhs.flops;
+            bytesRead += rhs.bytesRead;
+            bytesWritten += rhs.bytesWritten;
+            return *this;
+        }
+
+        string toString() const;
+    };
+
+} // namespace infini
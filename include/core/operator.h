@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/op_cost.h"
 #include "core/op_type.h"
 #include "core/tensor.h"
 
@@ -8,21 +9,34 @@ namespace infini
     using KernelAttrs = std::tuple<Device, OpType::underlying_t>;
 
     class GraphObj;
-    class OperatorObj : public Object
+    class OperatorObj : public Object,
+                        public std::enable_shared_from_this<OperatorObj>
     {
         friend class GraphObj;
+        friend class GraphRewriter;
 
     protected:
         OpType type;
         TensorVec inputs;
         TensorVec outputs;
-        vector<WRef<OperatorObj>> predecessors;
-        vector<WRef<OperatorObj>> successors;
+        // Ops are owned by their graph, which outlives the edges.
+        vector<OperatorObj *> predecessors;
+        vector<OperatorObj *> successors;
 
     public:
         OperatorObj(OpType opType, TensorVec inputs, TensorVec outputs);
         virtual optional<vector<Shape>> inferShape(const TensorVec &inputs) = 0;
         virtual vector<DataType> inferDataType(const TensorVec &inputs) const;
+        /**
+         * @brief Output shapes in terms of the dimension variables of the input
+         * shapes. nullopt if the op does not support symbolic dims or cannot
+         * prove the inputs compatible for every binding.
+         */
+        virtual optional<vector<SymShape>>
+        inferSymbolicShape(const vector<SymShape> &inputs) const
+        {
+            return std::nullopt;
+        }
         /**
          * @brief Constructs outputs (if requried) and check whether the operator is
          * valid.
@@ -32,6 +46,13 @@ namespace infini
          */
         bool checkValid(GraphObj *graph);
 
+        /**
+         * @brief Work of one execution with the current shapes. By default
+         * every input and output is streamed once with one flop per output
+         * element, which fits element-wise ops.
+         */
+        virtual OpCost getCost() const;
+
     public: // getter and setter
         const TensorVec &getInputs() const { return inputs; }
         const TensorVec &getOutputs() const { return outputs; }
@@ -46,8 +67,14 @@ namespace infini
             IT_ASSERT(i < outputs.size(), "Index exceeded");
             return outputs.at(i);
         }
-        OpVec getPredecessors() const { return wrefs_to_refs(predecessors); }
-        OpVec getSuccessors() const { return wrefs_to_refs(successors); }
+        OpVec getPredecessors() const { return ptrs_to_refs(getPredecessorView()); }
+        OpVec getSuccessors() const { return ptrs_to_refs(getSuccessorView()); }
+        /**
+         * @brief Allocation-free alternatives to getPredecessors and
+         * getSuccessors for traversals.
+         */
+        OpView getPredecessorView() const { return predecessors; }
+        OpView getSuccessorView() const { return successors; }
         OpType getOpType() const { return type; }
         // HACK: set correct data type
         DataType getDType() const { return getInputs(0)->getDType(); }
@@ -65,15 +92,29 @@ namespace infini
         virtual Operator clone(const TensorVec &newInputs,
                                const TensorVec &newOutputs) const = 0;
 
+        /**
+         * @brief Attributes that, with the type and the inputs, determine the
+         * outputs. nullopt for ops that cannot be compared, which keeps them
+         * out of common subexpression elimination.
+         */
+        virtual optional<vector<int64_t>> getAttributes() const
+        {
+            return std::nullopt;
+        }
+
     protected:
         optional<vector<Shape>> inferShape();
         vector<DataType> inferDataType() const;
 
     private:
-        void addPredecessors(const Operator &op) { predecessors.emplace_back(op); }
-        void addSuccessors(const Operator &op) { successors.emplace_back(op); }
-        void removePredecessors(const Operator &op);
-        void removeSuccessors(const Operator &op);
+        void addPredecessors(OperatorObj *op) { predecessors.emplace_back(op); }
+        void addSuccessors(OperatorObj *op) { successors.emplace_back(op); }
+        void addPredecessors(const Operator &op) { addPredecessors(op.get()); }
+        void addSuccessors(const Operator &op) { addSuccessors(op.get()); }
+        void removePredecessors(const OperatorObj *op);
+        void removeSuccessors(const OperatorObj *op);
+        void removePredecessors(const Operator &op) { removePredecessors(op.get()); }
+        void removeSuccessors(const Operator &op) { removeSuccessors(op.get()); }
         void replaceInput(Tensor t1, Tensor t2);
     };
 
@@ -32,6 +32,36 @@ std::vector<WRef<T>> refs_to_wrefs(const std::vector<Ref<T>> &refs) {
     return wrefs;
 }
 
+/**
+ * @brief Non-owning view of a vector of raw pointers, e.g. the edges of a
+ * graph node. Iterating it neither allocates nor touches reference counts.
+ * It is invalidated when the vector changes.
+ */
+template <typename T> class PtrView {
+    T *const *first, *const *last;
+
+  public:
+    PtrView(const std::vector<T *> &ptrs)
+        : first(ptrs.data()), last(ptrs.data() + ptrs.size()) {}
+    T *const *begin() const { return first; }
+    T *const *end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    T *operator[](size_t i) const { return first[i]; }
+};
+
+/**
+ * @brief Owning references to the objects of a view, which must derive from
+ * std::enable_shared_from_this.
+ */
+template <typename T> std::vector<Ref<T>> ptrs_to_refs(PtrView<T> ptrs) {
+    std::vector<Ref<T>> refs;
+    refs.reserve(ptrs.size());
+    for (T *ptr : ptrs)
+        refs.emplace_back(ptr->shared_from_this());
+    return refs;
+}
+
 template <typename T>
 std::vector<Ref<T>> wrefs_to_refs(const std::vector<WRef<T>> &wrefs) {
     std::vector<Ref<T>> refs;
@@ -0,0 +1,199 @@
+#pragma once
+#include "core/graph.h"
+#include <deque>
+#include <functional>
+
+namespace infini
+{
+    /**
+     * @brief Op-level pattern: an op of a type satisfying an attribute
+     * predicate, whose inputs may in turn be produced by matching ops.
+     */
+    struct Pattern
+    {
+        OpType type;
+        // Accepts every op of the type if empty.
+        std::function<bool(const Operator &)> predicate;
+        // (input index, pattern of the op producing that input)
+        vector<pair<int, Pattern>> inputs;
+
+        Pattern(OpType type,
+                std::function<bool(const Operator &)> predicate = nullptr,
+                vector<pair<int, Pattern>> inputs = {})
+            : type(type), predicate(std::move(predicate)),
+              inputs(std::move(inputs)) {}
+
+        /**
+         * @brief Matches `op` and appends it and the ops matched by the input
+         * patterns (in pre-order) to `matched`.
+         */
+        bool match(const Operator &op, OpVec &matched) const;
+    };
+
+    class GraphRewriter;
+
+    class RewriteRule
+    {
+    public:
+        virtual ~RewriteRule() {}
+
+        /**
+         * @brief Pattern whose root op anchors the rule.
+         */
+        virtual Pattern getPattern() const = 0;
+
+        /**
+         * @brief Rewrites a match, ops as ordered by Pattern::match. Returns
+         * false to leave the graph unchanged.
+         */
+        virtual bool rewrite(GraphRewriter &rewriter,
+                             const OpVec &matched) const = 0;
+    };
+
+    class RewriteRuleRegistry
+    {
+    public:
+        struct RuleRecord
+        {
+            RewriteRule *rule;
+            string name;
+            Pattern pattern;
+        };
+
+    private:
+        // Root op type -> rules anchored at it, in registration order.
+        std::map<OpType, vector<RuleRecord>> rules;
+
+    public:
+        ~RewriteRuleRegistry()
+        {
+            for (auto &[type, records] : rules)
+                for (auto &record : records)
+                    delete record.rule;
+        }
+        static RewriteRuleRegistry &getInstance()
+        {
+            static RewriteRuleRegistry instance;
+            return instance;
+        }
+        bool registerRule(RewriteRule *rule, string name)
+        {
+            auto pattern = rule->getPattern();
+            rules[pattern.type].push_back({rule, name, std::move(pattern)});
+            return true;
+        }
+        const vector<RuleRecord> &getRules(OpType type) const
+        {
+            static const vector<RuleRecord> none;
+            auto it = rules.find(type);
+            return it == rules.end() ? none : it->second;
+        }
+    };
+
+    /**
+     * @brief Applies registered rules to a graph until none matches.
+     *
+     * A worklist initially holds every op. After a rewrite only the ops
+     * around the changed nodes are revisited. Erased ops and tensors are
+     * removed from the graph in one pass at the end.
+     */
+    class GraphRewriter
+    {
+        GraphObj &graph;
+        std::deque<Operator> worklist;
+        std::unordered_set<const OperatorObj *> queued;
+        std::unordered_set<const OperatorObj *> erased;
+        // Position of each op in the graph order, to detect when a rewrite
+        // invalidates the topological order.
+        std::unordered_map<const OperatorObj *, size_t> positions;
+        // Ops inserted before each op, in insertion order. Inserted ops share
+        // the position of the op they precede.
+        std::unordered_map<const OperatorObj *, OpVec> inserted;
+        std::unordered_map<const OperatorObj *, pair<const OperatorObj *, size_t>>
+            insertedAt;
+        bool orderValid;
+        // Tensors that may have lost their producer and all consumers.
+        std::unordered_set<const TensorObj *> detached;
+        bool changed;
+
+    public:
+        explicit GraphRewriter(GraphObj &graph);
+
+        /**
+         * @brief Runs the rules until a fixpoint. Returns if the graph
+         * changed.
+         */
+        bool run();
+
+        /**
+         * @brief Removes erased ops and dead tensors from the graph and
+         * restores its topological order. Passes that call the mutation
+         * primitives directly finish with it. Returns if the graph changed.
+         */
+        bool commit();
+
+        /**
+         * @brief Queues an op to be matched again.
+         */
+        void enqueue(const Operator &op);
+
+        /**
+         * @brief Makes every consumer of `from` consume `to` instead. Rules
+         * must not replace graph outputs (GraphObj::isOutput).
+         */
+        void replaceAllUses(const Tensor &from, const Tensor &to);
+
+        /**
+         * @brief Redirects a single consumer of `from` to `to`.
+         */
+        void replaceUse(const Operator &op, const Tensor &from,
+                        const Tensor &to);
+
+        /**
+         * @brief Makes the producer of `from` produce `to`, which has no
+         * producer, and moves the consumers of `from` to `to`. Keeps a graph
+         * output when the op computing it is erased.
+         */
+        void moveOutput(const Tensor &from, const Tensor &to);
+
+        /**
+         * @brief Disconnects an op. Its outputs must have no consumers left,
+         * unless another op produces them now.
+         */
+        void eraseOperator(const Operator &op);
+
+        /**
+         * @brief Adds an op to the graph right before `before`. Its outputs
+         * may be existing tensors whose producer is erased afterwards.
+         */
+        void insertOperator(const Operator &op, const Operator &before);
+
+        Tensor addTensor(Shape dims, DataType dtype)
+        {
+            return graph.addTensor(std::move(dims), dtype);
+        }
+
+        bool isErased(const Operator &op) const { return erased.count(op.get()); }
+
+        const GraphObj &getGraph() const { return graph; }
+
+    private:
+        void enqueue(OperatorObj *op);
+        void enqueueNeighbors(const Operator &op);
+        // If `a` runs before `b` in the order being rewritten. Conservative
+        // for ops inserted at different places.
+        bool precedes(const OperatorObj *a, const OperatorObj *b) const;
+        void compact();
+    };
+
+} // namespace infini
+
+#define _REGISTER_REWRITE_RULE_1(rule, name, cnt)                             \
+    namespace infini                                                          \
+    {                                                                         \
+        static const bool _CAT(_register_rewrite_rule_, cnt) =                \
+            RewriteRuleRegistry::getInstance().registerRule(new rule(), name); \
+    }
+
+#define REGISTER_REWRITE_RULE(rule, name) \
+    _REGISTER_REWRITE_RULE_1(rule, name, __COUNTER__)
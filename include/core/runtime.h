@@ -1,5 +1,7 @@
 #pragma once
+#include "core/caching_allocator.h"
 #include "core/common.h"
+#include "core/machine_model.h"
 #include "core/op_type.h"
 #include "core/ref.h"
 
@@ -19,6 +21,7 @@ namespace infini
 
   using TensorVec = vector<Tensor>;
   using OpVec = vector<Operator>;
+  using OpView = PtrView<OperatorObj>;
 
   enum class Device
   {
@@ -38,9 +41,27 @@ namespace infini
     virtual ~RuntimeObj() {}
 
     virtual void run(const Graph &graph) const = 0;
+    /**
+     * @brief Memory of at least `size` bytes with undefined contents.
+     */
     virtual void *alloc(size_t size) = 0;
+    /**
+     * @brief Zero-filled memory of at least `size` bytes.
+     */
+    virtual void *allocZeroed(size_t size) = 0;
     virtual void dealloc(void *ptr) = 0;
 
+    Device getDevice() const { return device; }
+
+    /**
+     * @brief Constants predicting op times on this runtime's machine.
+     */
+    virtual const MachineModel &getMachineModel() const
+    {
+      static const MachineModel nominal;
+      return nominal;
+    }
+
     bool isCpu() const
     {
       return true;
@@ -51,8 +72,16 @@ namespace infini
 
   class NativeCpuRuntimeObj : public RuntimeObj
   {
+    // Decides how many threads each kernel runs with.
+    MachineModel machineModel;
+
+    // Arenas come from and return to CachingAllocator::getInstance().
+    ArenaOptions arenaOptions;
+
   public:
-    NativeCpuRuntimeObj() : RuntimeObj(Device::CPU) {}
+    NativeCpuRuntimeObj()
+        : RuntimeObj(Device::CPU),
+          machineModel(MachineModel::loadOrCalibrate()) {}
 
     static Ref<NativeCpuRuntimeObj> &getInstance()
     {
@@ -63,7 +92,17 @@ namespace infini
     void dealloc(void *ptr) override;
     void run(const Graph &graph) const override;
     void *alloc(size_t size) override;
+    void *allocZeroed(size_t size) override;
     string toString() const override;
+
+    const MachineModel &getMachineModel() const override
+    {
+      return machineModel;
+    }
+    void setMachineModel(const MachineModel &model) { machineModel = model; }
+
+    const ArenaOptions &getArenaOptions() const { return arenaOptions; }
+    void setArenaOptions(const ArenaOptions &options) { arenaOptions = options; }
   };
 
 } // namespace infini
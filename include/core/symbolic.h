@@ -0,0 +1,58 @@
+#pragma once
+#include "core/common.h"
+
+namespace infini
+{
+    using SymBindings = std::map<string, int64_t>;
+
+    /**
+     * @brief Integer polynomial over named dimension variables, such as
+     * `2*b*s + 4`. Affine expressions cover the dims of most shapes, and
+     * products appear in element counts and byte sizes.
+     */
+    class SymExpr
+    {
+        // Monomial (sorted variable names, repeated for powers) -> coefficient.
+        // The constant term has an empty monomial. No zero coefficients.
+        std::map<vector<string>, int64_t> terms;
+
+    public:
+        SymExpr(int64_t constant = 0);
+        static SymExpr var(const string &name);
+
+        SymExpr operator+(const SymExpr &rhs) const;
+        SymExpr operator-(const SymExpr &rhs) const;
+        SymExpr operator*(const SymExpr &rhs) const;
+        bool operator==(const SymExpr &rhs) const { return terms == rhs.terms; }
+        bool operator!=(const SymExpr &rhs) const { return terms != rhs.terms; }
+
+        /**
+         * @brief The value if the expression has no variables.
+         */
+        optional<int64_t> getConstant() const;
+
+        /**
+         * @brief Evaluates the expression. Every variable must be bound.
+         */
+        int64_t evaluate(const SymBindings &bindings) const;
+
+        string toString() const;
+    };
+
+    using SymShape = vector<SymExpr>;
+
+    /**
+     * @brief A symbolic shape with the given concrete dims.
+     */
+    SymShape toSymShape(const vector<int> &dims);
+
+    vector<int> evaluate(const SymShape &shape, const SymBindings &bindings);
+
+    /**
+     * @brief Product of the dims.
+     */
+    SymExpr getNumElements(const SymShape &shape);
+
+    string toString(const SymShape &shape);
+
+} // namespace infini
@@ -3,6 +3,8 @@
 #include "core/data_type.h"
 #include "core/object.h"
 #include "core/runtime.h"
+#include "core/symbolic.h"
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <fstream>
@@ -12,21 +14,35 @@ namespace infini
     class GraphObj;
     using ShapeElem = int;
     using Shape = vector<ShapeElem>;
+    enum class TensorType
+    {
+        Error = 0,
+        Input = 1,
+        Initialized = 2,
+        Other = 3
+    };
     class TensorObj : public Object
     {
         friend class GraphObj;
+        friend class GraphRewriter;
 
     protected:
         int dim;
 
         DataType dtype;
-        vector<WRef<OperatorObj>> targets;
+        TensorType tensorType = TensorType::Other;
+        // A consumer appears once per input it reads. Ops are owned by the
+        // graph.
+        vector<OperatorObj *> targets;
         WRef<OperatorObj> source;
         Blob data;
         Runtime runtime;
 
     private:
         Shape shape;
+        // Shape in terms of dimension variables, set by the caller for graph
+        // inputs and by GraphObj::inferSymbolicShapes for the others.
+        optional<SymShape> symbolicShape;
         size_t _size; // Cache of Π(shape).
         Fuid fuid;    // Cloned tensors share the same id. Tensors constructed from
                       // scratch have a new id.
@@ -39,15 +55,43 @@ namespace infini
         size_t size() const { return _size; }
         size_t getBytes() const { return _size * dtype.getSize(); }
 
+        /**
+         * @brief Clone a tensor without its data and connections. The clone
+         * shares the FUID of this tensor.
+         */
+        Tensor clone() const
+        {
+            auto obj = make_ref<TensorObj>(*this);
+            obj->data = nullptr;
+            obj->targets.clear();
+            obj->source.reset();
+            return obj;
+        }
+
         Shape getDims() const { return shape; }
         void setShape(Shape shape_);
         size_t getRank() const { return shape.size(); }
+        const optional<SymShape> &getSymbolicShape() const
+        {
+            return symbolicShape;
+        }
+        void setSymbolicShape(optional<SymShape> shape_);
         UidBaseType getFuid() const { return fuid; }
 
         void setData(
             std::function<void(void *, size_t, DataType)> const &generator) const;
 
         void setDataBlob(const Blob &blob);
+        bool hasData() const { return data != nullptr; }
+
+        /**
+         * @brief Marks a constant initializer. Weights live in the graph's
+         * weight region instead of the activation arena.
+         */
+        void setWeight() { tensorType = TensorType::Initialized; }
+        void setInput() { tensorType = TensorType::Input; }
+        bool isWeight() const { return tensorType == TensorType::Initialized; }
+        TensorType getTensorType() const { return tensorType; }
 
         void printData() const;
         bool equalData(const Tensor &rhs, double relativeError = 1e-6) const;
@@ -65,17 +109,26 @@ namespace infini
         {
             static_assert(std::is_pointer_v<T>,
                           "Raw data pointer has a type of pointer");
-            IT_ASSERT(data != nullptr);
-            return data->getPtr<T>();
+            return reinterpret_cast<T>(getDataPtr());
         }
 
         DataType getDType() const { return dtype; }
         Runtime getRuntime() const { return runtime; }
 
-        OpVec getTargets() const { return wrefs_to_refs(targets); }
+        OpVec getTargets() const;
+        /**
+         * @brief Allocation-free alternative to getTargets for traversals.
+         */
+        OpView getTargetView() const { return targets; }
         Operator getSource() const { return source.lock(); }
 
     private:
+        /**
+         * @brief Resolves the storage of this tensor. The execution context
+         * active on the calling thread takes precedence over the bound blob.
+         */
+        void *getDataPtr() const;
+
         template <class T>
         string dataToString() const
         {
@@ -84,7 +137,7 @@ namespace infini
 
             auto numDims = shape.size();
             auto dimSzVec = vector<int>(numDims, 1);
-            auto ptr = data->getPtr<T *>();
+            auto ptr = getRawDataPtr<T *>();
             dimSzVec[numDims - 1] = shape[numDims - 1];
 
             for (int i = numDims - 1; i != 0; --i)
@@ -147,17 +200,12 @@ namespace infini
             return true;
         }
 
-        void addTarget(const Operator &op) { targets.emplace_back(op); }
+        void addTarget(const Operator &op) { targets.emplace_back(op.get()); }
         void setSource(const Operator &op) { source = op; }
         void removeTarget(const Operator &op)
         {
-            for (auto itr = targets.begin(); itr != targets.end();)
-            {
-                if (itr->lock() == op)
-                    itr = targets.erase(itr);
-                else
-                    ++itr;
-            }
+            targets.erase(std::remove(targets.begin(), targets.end(), op.get()),
+                          targets.end());
         }
     };
 
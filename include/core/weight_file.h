@@ -0,0 +1,70 @@
+#pragma once
+#include "core/tensor.h"
+
+namespace infini
+{
+    class WeightFileObj;
+    using WeightFile = Ref<WeightFileObj>;
+
+    /**
+     * @brief A weight file mapped read-only into memory.
+     *
+     * Layout (native byte order):
+     *   header   "ITWEIGHT", uint32 version, uint32 number of entries
+     *   entries  uint32 name length, name, int32 dtype, uint32 rank,
+     *            int32 dims[rank], uint64 offset, uint64 bytes
+     *   data     each entry at a page-aligned offset from the file start
+     *
+     * Binding a tensor points its blob into the mapping without copying, so
+     * only touched pages become resident and processes serving the same
+     * model share the page cache. Bound tensors are read-only.
+     */
+    class WeightFileObj : public std::enable_shared_from_this<WeightFileObj>
+    {
+    public:
+        static constexpr size_t dataAlignment = 4096;
+
+        struct Entry
+        {
+            DataType dtype;
+            Shape dims;
+            size_t offset;
+            size_t bytes;
+        };
+
+    private:
+        Runtime runtime;
+        void *base;
+        size_t length;
+        std::unordered_map<string, Entry> entries;
+
+    public:
+        /**
+         * @brief Maps the weight file at `path`.
+         */
+        static WeightFile open(Runtime runtime, const string &path);
+
+        /**
+         * @brief Writes named tensors with their data to `path`.
+         */
+        static void save(const string &path,
+                         const vector<pair<string, Tensor>> &weights);
+
+        WeightFileObj(Runtime runtime, void *base, size_t length,
+                      std::unordered_map<string, Entry> entries);
+        ~WeightFileObj();
+        WeightFileObj(const WeightFileObj &) = delete;
+        WeightFileObj &operator=(const WeightFileObj &) = delete;
+
+        bool contains(const string &name) const;
+        const Entry &getEntry(const string &name) const;
+        vector<string> getNames() const;
+
+        /**
+         * @brief Binds `tensor` to the entry `name` in place and marks it as
+         * a weight. The dtype and shape must match the entry.
+         */
+        void bind(const Tensor &tensor, const string &name);
+    };
+
+} // namespace infini
@@ -0,0 +1,53 @@
+#pragma once
+#include "core/tensor.h"
+
+namespace infini
+{
+    class WeightRegionObj;
+    using WeightRegion = Ref<WeightRegionObj>;
+
+    /**
+     * @brief Persistent storage of the weights of a model, kept apart from
+     * the activation arena.
+     *
+     * The layout is fixed at construction, so re-planning activations never
+     * moves weights. Entries are keyed by FUID: graphs built from clones of
+     * the same weight tensors (e.g. different batch buckets of one model)
+     * can share a single region.
+     */
+    class WeightRegionObj
+    {
+    private:
+        Runtime runtime;
+        void *ptr;
+        size_t size;
+        // fuid -> (offset, bytes)
+        std::unordered_map<UidBaseType, pair<size_t, size_t>> entries;
+
+    public:
+        /**
+         * @brief Lays out and allocates storage for `weights`.
+         */
+        WeightRegionObj(Runtime runtime, const TensorVec &weights,
+                        size_t alignment);
+        ~WeightRegionObj();
+        WeightRegionObj(const WeightRegionObj &) = delete;
+        WeightRegionObj &operator=(const WeightRegionObj &) = delete;
+
+        /**
+         * @brief If the region holds storage for the tensor's family with a
+         * matching size.
+         */
+        bool contains(const Tensor &tensor) const;
+
+        /**
+         * @brief Storage of a tensor held by the region.
+         */
+        void *getPtr(const Tensor &tensor) const;
+
+        size_t getSize() const { return size; }
+        size_t getNumEntries() const { return entries.size(); }
+        Runtime getRuntime() const { return runtime; }
+    };
+
+} // namespace infini
@@ -23,10 +23,16 @@ class ConcatObj : public OperatorObj {
     OP_CLONE(ConcatObj);
 
     optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+    optional<vector<SymShape>>
+    inferSymbolicShape(const vector<SymShape> &inputs) const override;
+    OpCost getCost() const override;
 
     std::string toString() const override;
     int numInputs() const override { return inputs.size(); }
     int numOutputs() const override { return 1; }
     int getDim() const { return dim; }
+    optional<vector<int64_t>> getAttributes() const override {
+        return vector<int64_t>{dim};
+    }
 };
 } // namespace infini
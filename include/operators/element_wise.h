@@ -24,8 +24,14 @@ namespace infini
     ElementWiseObj(OpType type, GraphObj *graph, Tensor input0, Tensor input1,
                    Tensor output);
     optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+    optional<vector<SymShape>>
+    inferSymbolicShape(const vector<SymShape> &inputs) const override;
 
     std::string toString() const override;
+    optional<vector<int64_t>> getAttributes() const override
+    {
+      return vector<int64_t>{};
+    }
     int numInputs() const override { return 2; }
     int numOutputs() const override { return 1; }
     };
@@ -15,9 +15,6 @@ namespace infini
         // oppsite to the column-major BLAS.
         bool transA, transB;
 
-        // Auxiliary attributes which are not a part of operator attributes.
-        int m, n, k;
-
     public:
         /**
          * @brief Matmul operator with batch broadcast and tensor transpose
@@ -44,6 +41,9 @@ namespace infini
 
         std::string toString() const override;
         optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+        optional<vector<SymShape>>
+        inferSymbolicShape(const vector<SymShape> &inputs) const override;
+        OpCost getCost() const override;
 
         int numInputs() const override { return inputs.size(); }
         int numOutputs() const override { return 1; }
@@ -52,9 +52,15 @@ namespace infini
         bool getTransB() const { return transB; }
         void setTransA(bool transA) { this->transA = transA; }
         void setTransB(bool transB) { this->transB = transB; }
-        int getM() const { return m; }
-        int getN() const { return n; }
-        int getK() const { return k; }
+        // Derived from the current input shapes, which may be rebound by
+        // GraphObj::bindDims without re-running inferShape.
+        int getM() const;
+        int getN() const;
+        int getK() const;
+        optional<vector<int64_t>> getAttributes() const override
+        {
+            return vector<int64_t>{transA, transB};
+        }
     };
 
 } // namespace infini
\ No newline at end of file
@@ -22,11 +22,19 @@ namespace infini
                  vector<int> permute);
     OP_CLONE(TransposeObj);
     optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+    optional<vector<SymShape>>
+    inferSymbolicShape(const vector<SymShape> &inputs) const override;
+    OpCost getCost() const override;
 
     std::string toString() const override;
     int numInputs() const override { return 1; }
     int numOutputs() const override { return 1; }
     std::vector<int> getPermute() const { return transposePermute; }
+    void setPermute(vector<int> permute) { transposePermute = std::move(permute); }
+    optional<vector<int64_t>> getAttributes() const override
+    {
+      return vector<int64_t>(transposePermute.begin(), transposePermute.end());
+    }
 
   private:
     vector<int> transposePermute;
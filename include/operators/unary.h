@@ -20,8 +20,14 @@ namespace infini
      */
     UnaryObj(OpType type, GraphObj *graph, Tensor input, Tensor output);
     optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+    optional<vector<SymShape>>
+    inferSymbolicShape(const vector<SymShape> &inputs) const override;
 
     std::string toString() const override;
+    optional<vector<int64_t>> getAttributes() const override
+    {
+      return vector<int64_t>{};
+    }
     int numInputs() const override { return 1; }
     int numOutputs() const override { return 1; }
   };
@@ -33,10 +39,14 @@ namespace infini
             std::optional<float> min, std::optional<float> max);
     OP_CLONE(ClipObj);
     optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+    optional<vector<SymShape>>
+    inferSymbolicShape(const vector<SymShape> &inputs) const override;
+    OpCost getCost() const override;
 
     std::string toString() const override;
     std::optional<float> getMin() const { return minValue; };
     std::optional<float> getMax() const { return maxValue; };
+    optional<vector<int64_t>> getAttributes() const override;
     int numInputs() const override { return 1; }
     int numOutputs() const override { return 1; }
 
@@ -79,11 +89,17 @@ namespace infini
     CastObj(GraphObj *graph, Tensor input, Tensor output, CastType type);
     OP_CLONE(CastObj);
     optional<vector<Shape>> inferShape(const TensorVec &inputs) override;
+    optional<vector<SymShape>>
+    inferSymbolicShape(const vector<SymShape> &inputs) const override;
     vector<DataType> inferDataType(const TensorVec &inputs) const override;
 
     std::string toString() const override;
     CastType getType() const { return castType; }
     DataType getOutputDataType() const;
+    optional<vector<int64_t>> getAttributes() const override
+    {
+      return vector<int64_t>{static_cast<int64_t>(castType)};
+    }
     int numInputs() const override { return 1; }
     int numOutputs() const override { return 1; }
 
@@ -11,6 +11,8 @@ namespace infini {
 
 // Launch a broadcast shape based on the shape of input A and B
 Shape infer_broadcast(const Shape &A, const Shape &B);
+// Symbolic broadcast, nullopt if a pair of dims is not provably compatible
+optional<SymShape> infer_broadcast(const SymShape &A, const SymShape &B);
 // Launch the real axis based on rank and current axis
 int get_real_axis(const int &axis, const int &rank);
 // Locate the index with size from Shape
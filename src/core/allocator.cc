@@ -1,18 +1,23 @@
 #include "core/allocator.h"
+#include <algorithm>
 #include <utility>
 
 namespace infini
 {
-    Allocator::Allocator(Runtime runtime) : runtime(runtime)
+    Allocator::Allocator(Runtime runtime, size_t alignment)
+        : runtime(runtime), alignment(alignment)
     {
         used = 0;
         peak = 0;
         ptr = nullptr;
-
-        // 'alignment' defaults to sizeof(uint64_t), because it is the length of
-        // the longest data type currently supported by the DataType field of
-        // the tensor
-        alignment = sizeof(uint64_t);
+        capacity = 0;
+        frozen = false;
+
+        // 'alignment' must be at least sizeof(uint64_t), the length of the
+        // longest data type currently supported by the DataType field of the
+        // tensor
+        IT_ASSERT(alignment >= sizeof(uint64_t) &&
+                  alignment % sizeof(uint64_t) == 0);
     }
 
     Allocator::~Allocator()
@@ -25,7 +30,7 @@ namespace infini
 
     size_t Allocator::alloc(size_t size)
     {
-        IT_ASSERT(this->ptr == nullptr);
+        IT_ASSERT(!this->frozen, "Plan is frozen, call reset() first");
         // pad the size to the multiple of alignment
         size = this->getAlignedSize(size);
 
@@ -35,38 +40,15 @@ namespace infini
         // 2) 若没有合适空闲块，则从末尾 bump 分配
         // 返回分配块的起始 offset
         // =================================== 作业 ===================================
-        size_t bestStart = 0;
-        size_t bestSize = 0;
-        bool found = false;
-        for (const auto &kv : freeBlocks)
+        // Smallest block that fits; ties go to the lowest offset.
+        auto fit = freeBlocksBySize.lower_bound({size, 0});
+        if (fit != freeBlocksBySize.end())
         {
-            const size_t start = kv.first;
-            const size_t blkSize = kv.second;
-            if (blkSize < size)
-                continue;
-            if (!found || blkSize < bestSize)
-            {
-                bestStart = start;
-                bestSize = blkSize;
-                found = true;
-                if (blkSize == size)
-                    break;
-            }
-        }
-
-        if (found)
-        {
-            auto it = freeBlocks.find(bestStart);
-            IT_ASSERT(it != freeBlocks.end());
-            if (bestSize == size)
-            {
-                freeBlocks.erase(it);
-            }
-            else
-            {
-                freeBlocks.erase(it);
-                freeBlocks.emplace(bestStart + size, bestSize - size);
-            }
+            const size_t bestSize = fit->first;
+            const size_t bestStart = fit->second;
+            eraseFreeBlock(freeBlocks.find(bestStart));
+            if (bestSize != size)
+                insertFreeBlock(bestStart + size, bestSize - size);
             return bestStart;
         }
 
@@ -79,7 +61,7 @@ namespace infini
 
     void Allocator::free(size_t addr, size_t size)
     {
-        IT_ASSERT(this->ptr == nullptr);
+        IT_ASSERT(!this->frozen, "Plan is frozen, call reset() first");
         size = getAlignedSize(size);
 
         // =================================== 作业 ===================================
@@ -108,7 +90,7 @@ namespace infini
                 if (start + blkSize != this->used)
                     break;
                 this->used = start;
-                freeBlocks.erase(it);
+                eraseFreeBlock(it);
             }
             return;
         }
@@ -125,7 +107,7 @@ namespace infini
             {
                 newStart = prev->first;
                 newSize += prev->second;
-                freeBlocks.erase(prev);
+                eraseFreeBlock(prev);
             }
         }
 
@@ -133,22 +115,49 @@ namespace infini
         if (next != freeBlocks.end() && newStart + newSize == next->first)
         {
             newSize += next->second;
-            freeBlocks.erase(next);
+            eraseFreeBlock(next);
         }
 
-        freeBlocks.emplace(newStart, newSize);
+        insertFreeBlock(newStart, newSize);
+    }
+
+    void Allocator::insertFreeBlock(size_t addr, size_t size)
+    {
+        freeBlocks.emplace(addr, size);
+        freeBlocksBySize.emplace(size, addr);
+    }
+
+    std::map<size_t, size_t>::iterator
+    Allocator::eraseFreeBlock(std::map<size_t, size_t>::iterator it)
+    {
+        IT_ASSERT(it != freeBlocks.end());
+        freeBlocksBySize.erase({it->second, it->first});
+        return freeBlocks.erase(it);
     }
 
     void *Allocator::getPtr()
     {
-        if (this->ptr == nullptr)
+        this->frozen = true;
+        if (this->ptr == nullptr || this->capacity < this->peak)
         {
-            this->ptr = runtime->alloc(this->peak);
-            printf("Allocator really alloc: %p %lu bytes\n", this->ptr, peak);
+            size_t size = std::max(this->peak, this->capacity * 2);
+            if (this->ptr != nullptr)
+                runtime->dealloc(this->ptr);
+            this->ptr = runtime->alloc(size);
+            this->capacity = size;
         }
         return this->ptr;
     }
 
+    void Allocator::reset()
+    {
+        used = 0;
+        peak = 0;
+        frozen = false;
+        freeBlocks.clear();
+        freeBlocksBySize.clear();
+    }
+
     size_t Allocator::getAlignedSize(size_t size)
     {
         return ((size - 1) / this->alignment + 1) * this->alignment;
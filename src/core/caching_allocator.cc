@@ -0,0 +1,173 @@
+#include "core/caching_allocator.h"
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace infini
+{
+    namespace
+    {
+        constexpr size_t hugePageSize = size_t(2) << 20;
+        constexpr size_t minSizeClass = size_t(64) << 10;
+        // Size classes per power of two.
+        constexpr size_t classesPerOctave = 4;
+
+        void *mapArena(size_t length, size_t alignment, bool huge, bool prefault)
+        {
+            // Anonymous mappings are zero-filled lazily by the kernel, so
+            // nothing is touched here unless prefaulting is requested.
+            const size_t pageSize = sysconf(_SC_PAGESIZE);
+            int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+            if (prefault)
+                flags |= MAP_POPULATE;
+
+            void *ptr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+            if (huge)
+                ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                           flags | MAP_HUGETLB, -1, 0);
+#endif
+            if (ptr != MAP_FAILED)
+                return ptr;
+
+            // Over-map so that an aligned range of `length` bytes fits, then
+            // give back the unaligned head and the tail.
+            const size_t mapped = length + alignment - pageSize;
+            void *start =
+                mmap(nullptr, mapped, PROT_READ | PROT_WRITE, flags, -1, 0);
+            IT_ASSERT(start != MAP_FAILED,
+                      "Failed to map " + std::to_string(length) + " bytes");
+            auto addr = reinterpret_cast<uintptr_t>(start);
+            auto aligned = (addr + alignment - 1) / alignment * alignment;
+            size_t head = aligned - addr, tail = mapped - head - length;
+            if (head > 0)
+                munmap(start, head);
+            if (tail > 0)
+                munmap(reinterpret_cast<char *>(aligned) + length, tail);
+            ptr = reinterpret_cast<void *>(aligned);
+#ifdef MADV_HUGEPAGE
+            if (huge)
+                madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+            return ptr;
+        }
+    } // namespace
+
+    CachingAllocator &CachingAllocator::getInstance()
+    {
+        // Leaked on purpose: blobs and graphs held in static storage may
+        // release their arenas after this would have been destroyed.
+        static auto *instance = new CachingAllocator();
+        return *instance;
+    }
+
+    size_t CachingAllocator::getSizeClass(size_t size)
+    {
+        if (size <= minSizeClass)
+            return minSizeClass;
+        size_t octave = minSizeClass;
+        while (octave * 2 < size)
+            octave *= 2;
+        size_t step = octave / classesPerOctave;
+        return (size + step - 1) / step * step;
+    }
+
+    void *CachingAllocator::alloc(size_t size, const ArenaOptions &options)
+    {
+        const size_t pageSize = sysconf(_SC_PAGESIZE);
+        const size_t sizeClass = getSizeClass(size);
+        const bool huge = options.hugePages && sizeClass >= hugePageSize;
+        const BinKey key{sizeClass, options.alignment, huge};
+
+        std::unique_lock<std::mutex> lock(mutex);
+        auto bin = bins.find(key);
+        if (bin != bins.end() && !bin->second.empty())
+        {
+            void *ptr = bin->second.back();
+            bin->second.pop_back();
+            const auto &block = blocks.at(ptr);
+            stats.cachedBytes -= block.length;
+            stats.inUseBytes += block.length;
+            ++stats.hits;
+            lock.unlock();
+            if (options.zero)
+                std::memset(ptr, 0, size);
+            return ptr;
+        }
+
+        const size_t alignment =
+            std::max({options.alignment, pageSize, huge ? hugePageSize : 0});
+        const size_t length = (sizeClass + alignment - 1) / alignment * alignment;
+        // Make room under the ceiling before mapping more.
+        size_t reserved = stats.inUseBytes + length;
+        trimLocked(ceiling > reserved ? ceiling - reserved : 0);
+        void *ptr = mapArena(length, alignment, huge, options.prefault);
+        blocks.emplace(ptr, Block{sizeClass, length, options.alignment, huge});
+        stats.inUseBytes += length;
+        ++stats.misses;
+        return ptr;
+    }
+
+    void CachingAllocator::dealloc(void *ptr)
+    {
+        if (ptr == nullptr)
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = blocks.find(ptr);
+        IT_ASSERT(it != blocks.end(), "Pointer not allocated by the runtime");
+        const auto &block = it->second;
+        bins[BinKey{block.sizeClass, block.alignment, block.hugePages}]
+            .emplace_back(ptr);
+        stats.inUseBytes -= block.length;
+        stats.cachedBytes += block.length;
+        trimLocked(ceiling > stats.inUseBytes ? ceiling - stats.inUseBytes : 0);
+    }
+
+    void CachingAllocator::setMemoryCeiling(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ceiling = bytes;
+        trimLocked(ceiling > stats.inUseBytes ? ceiling - stats.inUseBytes : 0);
+    }
+
+    size_t CachingAllocator::getMemoryCeiling()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return ceiling;
+    }
+
+    void CachingAllocator::trim(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        trimLocked(bytes);
+    }
+
+    CachingAllocator::Stats CachingAllocator::getStats()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+    void CachingAllocator::trimLocked(size_t cachedLimit)
+    {
+        // Largest classes first: fewest unmaps for the bytes released.
+        for (auto bin = bins.rbegin();
+             bin != bins.rend() && stats.cachedBytes > cachedLimit; ++bin)
+        {
+            auto &ptrs = bin->second;
+            while (!ptrs.empty() && stats.cachedBytes > cachedLimit)
+            {
+                void *ptr = ptrs.back();
+                ptrs.pop_back();
+                auto it = blocks.find(ptr);
+                size_t length = it->second.length;
+                blocks.erase(it);
+                munmap(ptr, length);
+                stats.cachedBytes -= length;
+                stats.trimmedBytes += length;
+            }
+        }
+    }
+
+} // namespace infini
@@ -0,0 +1,93 @@
+#include "core/execution_context.h"
+
+namespace infini
+{
+    static thread_local const ExecutionContextObj *activeContext = nullptr;
+
+    ExecutionContextObj::ActiveScope::ActiveScope(
+        const ExecutionContextObj &context)
+        : previous(activeContext)
+    {
+        activeContext = &context;
+    }
+
+    ExecutionContextObj::ActiveScope::~ActiveScope()
+    {
+        activeContext = previous;
+    }
+
+    ExecutionContextObj::ExecutionContextObj(Graph graph)
+        : graph(graph), runtime(graph->getRuntime()), arena(nullptr),
+          arenaSize(graph->getArenaSize())
+    {
+        const auto &offsets = graph->getTensorOffsets();
+        IT_ASSERT(!offsets.empty(),
+                  "dataMalloc must be called before creating a context");
+        IT_ASSERT(!graph->getOffloader(),
+                  "Execution contexts cannot be used with offloading");
+        if (arenaSize > 0)
+            arena = runtime->alloc(arenaSize);
+        bindings.reserve(offsets.size());
+        for (const auto &t : graph->getTensors())
+        {
+            if (!t->getSource())
+                continue;
+            auto it = offsets.find(t.get());
+            IT_ASSERT(it != offsets.end());
+            bindings.emplace(t.get(), static_cast<char *>(arena) + it->second);
+        }
+    }
+
+    ExecutionContextObj::~ExecutionContextObj()
+    {
+        if (arena != nullptr)
+            runtime->dealloc(arena);
+    }
+
+    string ExecutionContextObj::toString() const
+    {
+        std::ostringstream oss;
+        oss << "ExecutionContext " << guid << " of Graph, arena " << arena
+            << " " << arenaSize << " bytes, " << bindings.size()
+            << " bound tensors";
+        return oss.str();
+    }
+
+    void ExecutionContextObj::bindInput(const Tensor &tensor, void *ptr)
+    {
+        IT_ASSERT(!tensor->getSource(), "Only graph inputs can be bound");
+        IT_ASSERT(ptr != nullptr);
+        bindings[tensor.get()] = ptr;
+    }
+
+    void ExecutionContextObj::setInput(
+        const Tensor &tensor,
+        std::function<void(void *, size_t, DataType)> const &generator)
+    {
+        IT_ASSERT(!tensor->getSource(), "Only graph inputs can be set");
+        const auto &offsets = graph->getTensorOffsets();
+        auto it = offsets.find(tensor.get());
+        IT_ASSERT(it != offsets.end(), "Tensor is not planned in this graph");
+        void *ptr = static_cast<char *>(arena) + it->second;
+        bindings[tensor.get()] = ptr;
+        generator(ptr, tensor->size(), tensor->getDType());
+    }
+
+    void ExecutionContextObj::run()
+    {
+        ActiveScope scope(*this);
+        runtime->run(graph);
+    }
+
+    void *ExecutionContextObj::lookup(const TensorObj *tensor) const
+    {
+        auto it = bindings.find(tensor);
+        return it == bindings.end() ? nullptr : it->second;
+    }
+
+    const ExecutionContextObj *ExecutionContextObj::current()
+    {
+        return activeContext;
+    }
+
+} // namespace infini
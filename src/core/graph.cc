@@ -1,7 +1,8 @@
 #include "core/graph.h"
-#include "operators/matmul.h"
-#include "operators/transpose.h"
+#include "core/kernel.h"
+#include "core/rewrite.h"
 #include <algorithm>
+#include <cstring>
 #include <numeric>
 #include <queue>
 #include <unordered_map>
@@ -13,7 +14,96 @@ namespace infini
     void GraphObj::addOperatorAndConnect(const Operator &op)
     {
         sorted = false;
+        invalidatePlans();
+        inferredInputShapes.clear();
+        opIndex[op.get()] = ops.size();
         ops.push_back(op);
+        connect(op);
+    }
+
+    GraphObj::~GraphObj()
+    {
+        for (const auto &op : ops)
+        {
+            for (const auto &input : op->getInputs())
+                if (input)
+                    input->removeTarget(op);
+            op->predecessors.clear();
+            op->successors.clear();
+        }
+    }
+
+    void GraphObj::removeOperator(Operator op)
+    {
+        invalidatePlans();
+        inferredInputShapes.clear();
+        recomputeOps.erase(op->getGuid());
+        for (const auto &input : op->getInputs())
+            if (input)
+                input->removeTarget(op);
+        for (auto *pred : op->getPredecessorView())
+            pred->removeSuccessors(op);
+        for (auto *succ : op->getSuccessorView())
+            succ->removePredecessors(op);
+        op->predecessors.clear();
+        op->successors.clear();
+        if (auto pos = findOperator(op.get()))
+        {
+            ops.erase(ops.begin() + *pos);
+            opIndex.erase(op.get());
+        }
+    }
+
+    void GraphObj::removeTensor(Tensor tensor)
+    {
+        invalidatePlans();
+        inferredInputShapes.clear();
+        if (auto pos = findTensor(tensor->getFuid());
+            pos && tensors[*pos] == tensor)
+        {
+            tensors.erase(tensors.begin() + *pos);
+            tensorIndex.erase(tensor->getFuid());
+        }
+    }
+
+    optional<size_t> GraphObj::findTensor(UidBaseType fuid) const
+    {
+        auto lookup = [&]() -> optional<size_t>
+        {
+            auto it = tensorIndex.find(fuid);
+            if (it != tensorIndex.end() && it->second < tensors.size() &&
+                tensors[it->second]->getFuid() == fuid)
+                return it->second;
+            return std::nullopt;
+        };
+        if (auto pos = lookup())
+            return pos;
+        tensorIndex.clear();
+        for (size_t i = 0; i < tensors.size(); ++i)
+            tensorIndex.emplace(tensors[i]->getFuid(), i);
+        return lookup();
+    }
+
+    optional<size_t> GraphObj::findOperator(const OperatorObj *op) const
+    {
+        auto lookup = [&]() -> optional<size_t>
+        {
+            auto it = opIndex.find(op);
+            if (it != opIndex.end() && it->second < ops.size() &&
+                ops[it->second].get() == op)
+                return it->second;
+            return std::nullopt;
+        };
+        if (auto pos = lookup())
+            return pos;
+        opIndex.clear();
+        for (size_t i = 0; i < ops.size(); ++i)
+            opIndex.emplace(ops[i].get(), i);
+        return lookup();
+    }
+
+    void GraphObj::connect(const Operator &op)
+    {
         for (auto &input : op->getInputs())
         {
             if (input)
@@ -31,7 +121,7 @@ namespace infini
             if (output)
             {
                 output->setSource(op);
-                for (auto &succ : output->getTargets())
+                for (auto *succ : output->getTargetView())
                 {
                     succ->addPredecessors(op);
                     op->addSuccessors(succ);
@@ -51,9 +141,9 @@ namespace infini
         for (const auto &op : ops)
         {
             vector<UidBaseType> preds, succs;
-            for (auto &o : op->getPredecessors())
+            for (auto *o : op->getPredecessorView())
                 preds.emplace_back(o->getGuid());
-            for (auto &o : op->getSuccessors())
+            for (auto *o : op->getSuccessorView())
                 succs.emplace_back(o->getGuid());
             oss << "OP " << op->getGuid();
             oss << ", pred " << vecToString(preds);
@@ -69,441 +159,968 @@ namespace infini
         {
             return true;
         }
-        std::vector<Operator> sorted;
-        std::unordered_set<OperatorObj *> flags;
+        stages.clear();
+        // Kahn's algorithm: an op is ready once the producers of all its
+        // inputs are placed. Ops are scanned in their current order, and an
+        // op skipped by the scan is placed as soon as it becomes ready, so an
+        // order that is already topological is kept.
+        struct State
+        {
+            size_t pending, position;
+        };
+        std::unordered_map<const OperatorObj *, State> states;
+        states.reserve(ops.size());
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            size_t pending = 0;
+            for (const auto &input : ops[i]->getInputs())
+                pending += input && input->getSource();
+            states.emplace(ops[i].get(), State{pending, i});
+        }
+        std::vector<Operator> sorted, ready;
         sorted.reserve(ops.size());
-        flags.reserve(ops.size());
-        while (sorted.size() < ops.size())
+        for (size_t scan = 0; scan < ops.size(); ++scan)
         {
-            // Any node is move to sorted in this loop.
-            auto modified = false;
-            for (auto const &op : ops)
+            if (states.at(ops[scan].get()).pending > 0)
+                continue;
+            ready.emplace_back(ops[scan]);
+            while (!ready.empty())
             {
-                if (auto const &inputs = op->getInputs();
-                    flags.find(op.get()) == flags.end() &&
-                    std::all_of(inputs.begin(), inputs.end(),
-                                [&flags](auto const &input)
-                                {
-                                    auto ptr = input->getSource().get();
-                                    return !ptr || flags.find(ptr) != flags.end();
-                                }))
+                auto op = std::move(ready.back());
+                ready.pop_back();
+                sorted.emplace_back(op);
+                for (const auto &output : op->getOutputs())
                 {
-                    modified = true;
-                    sorted.emplace_back(op);
-                    flags.insert(op.get());
+                    if (!output)
+                        continue;
+                    // Targets hold a consumer once per input it reads.
+                    for (auto *target : output->getTargetView())
+                    {
+                        auto it = states.find(target);
+                        if (it != states.end() && --it->second.pending == 0 &&
+                            it->second.position < scan)
+                            ready.emplace_back(target->shared_from_this());
+                    }
                 }
             }
-            if (!modified)
-            {
-                return false;
-            }
+        }
+        if (sorted.size() < ops.size())
+        {
+            return false;
         }
         this->ops = std::move(sorted);
+        opIndex.clear();
         return this->sorted = true;
     }
 
-    void GraphObj::optimize()
+    bool GraphObj::reorderForMemory()
     {
-        // =================================== 作业 ===================================
-        // TODO: 设计一个算法来实现指定的图优化规则
-        // 图优化规则如下：
-        // 1. 去除冗余的算子（例如，两个相邻的算子都是 transpose 算子，且做的是相反的操作，可以将其全部删除）
-        // 2. 合并算子（例如，矩阵乘算子中含有属性transA、transB，如果其输入存在transpose，且对最后两个维度做交换，就可以将transpose融入到矩阵乘算子的属性中去）
-        // =================================== 作业 ===================================
-
         IT_ASSERT(topo_sort() == true);
-
-        auto is_swap_last_two = [](const vector<int> &perm, int rank) -> bool
+        auto outputBytes = [](const OperatorObj *op)
         {
-            if (rank < 2)
-                return false;
-            if ((int)perm.size() != rank)
-                return false;
-            for (int i = 0; i < rank - 2; ++i)
-                if (perm[i] != i)
-                    return false;
-            return perm[rank - 2] == rank - 1 && perm[rank - 1] == rank - 2;
+            size_t bytes = 0;
+            for (const auto &output : op->getOutputs())
+                bytes += output->getBytes();
+            return bytes;
         };
-
-        auto is_inverse_perm = [](const vector<int> &p, const vector<int> &q,
-                                  int rank) -> bool
+        // Producers of an op, each once, in the order they are emitted.
+        std::unordered_map<const OperatorObj *, size_t> need;
+        need.reserve(ops.size());
+        auto producersOf = [&](const OperatorObj *op)
         {
-            if ((int)p.size() != rank || (int)q.size() != rank)
-                return false;
-            vector<int> inv(rank, -1);
-            for (int i = 0; i < rank; ++i)
-            {
-                IT_ASSERT(p[i] >= 0 && p[i] < rank);
-                inv[p[i]] = i;
-            }
-            for (int i = 0; i < rank; ++i)
-            {
-                if (inv[i] != q[i])
-                    return false;
-            }
-            return true;
+            vector<OperatorObj *> producers;
+            for (const auto &input : op->getInputs())
+                if (auto source = input->getSource();
+                    source && std::find(producers.begin(), producers.end(),
+                                        source.get()) == producers.end())
+                    producers.emplace_back(source.get());
+            std::stable_sort(producers.begin(), producers.end(),
+                             [&](auto *a, auto *b)
+                             {
+                                 bool ra = recomputeOps.count(a->getGuid()),
+                                      rb = recomputeOps.count(b->getGuid());
+                                 if (ra != rb)
+                                     return rb;
+                                 return need.at(a) > need.at(b);
+                             });
+            return producers;
         };
-
-        auto cleanup_dangling_tensors = [&]()
+        // Peak bytes to compute an op from the graph inputs, treating its
+        // producers as independent subgraphs run one after another.
+        for (const auto &op : ops)
         {
-            for (auto it = tensors.begin(); it != tensors.end();)
+            size_t held = 0, peak = 0;
+            for (auto *producer : producersOf(op.get()))
             {
-                auto &t = *it;
-                if (!t)
-                {
-                    it = tensors.erase(it);
-                    continue;
-                }
-                if (t->targets.empty() && t->source.expired())
-                    it = tensors.erase(it);
-                else
-                    ++it;
+                peak = std::max(peak, held + need.at(producer));
+                held += outputBytes(producer);
             }
-        };
+            need.emplace(op.get(), std::max(peak, held + outputBytes(op.get())));
+        }
+
+        vector<OperatorObj *> sinks;
+        for (const auto &op : ops)
+            if (op->getSuccessorView().empty())
+                sinks.emplace_back(op.get());
+        std::stable_sort(sinks.begin(), sinks.end(), [&](auto *a, auto *b)
+                         { return need.at(a) > need.at(b); });
 
-        auto detach_op = [&](const Operator &op)
+        // Iterative post-order, as chains may be long.
+        struct Frame
         {
-            // Disconnect from predecessor/successor bookkeeping and tensor edges.
-            for (const auto &in : op->inputs)
+            OperatorObj *op;
+            bool expanded;
+            vector<OperatorObj *> producers;
+            size_t next;
+        };
+        OpVec order;
+        order.reserve(ops.size());
+        std::unordered_set<const OperatorObj *> visited;
+        vector<Frame> stack;
+        for (auto it = sinks.rbegin(); it != sinks.rend(); ++it)
+            stack.push_back({*it, false, {}, 0});
+        while (!stack.empty())
+        {
+            auto &frame = stack.back();
+            if (!frame.expanded)
             {
-                if (!in)
+                if (!visited.insert(frame.op).second)
+                {
+                    stack.pop_back();
                     continue;
-                in->removeTarget(op);
+                }
+                frame.expanded = true;
+                frame.producers = producersOf(frame.op);
             }
-            for (const auto &out : op->outputs)
+            if (frame.next < frame.producers.size())
             {
-                if (!out)
-                    continue;
-                if (out->source.lock() == op)
-                    out->source.reset();
+                auto *producer = frame.producers[frame.next++];
+                if (!visited.count(producer))
+                    stack.push_back({producer, false, {}, 0});
+                continue;
             }
+            order.emplace_back(frame.op->shared_from_this());
+            stack.pop_back();
+        }
+        IT_ASSERT(order.size() == ops.size());
 
-            for (const auto &pred : op->getPredecessors())
-                pred->removeSuccessors(op);
-            for (const auto &succ : op->getSuccessors())
-                succ->removePredecessors(op);
-
-            op->predecessors.clear();
-            op->successors.clear();
-        };
-
-        bool changed = false;
-        do
-        {
-            changed = false;
-
-            std::unordered_set<OperatorObj *> eraseOps;
+        memoryOrdered = true;
+        if (getPeakLiveBytes(order) >= getPeakLiveBytes(ops))
+            return false;
+        ops = std::move(order);
+        opIndex.clear();
+        stages.clear();
+        // Plans refer to steps; the shapes and their bindings stay valid.
+        planCache.clear();
+        symbolicPlan.reset();
+        return true;
+    }
 
-            // Rule 2: fuse Transpose(swapping last two dims) into Matmul's transA/transB.
-            for (size_t opIdx = 0; opIdx < ops.size(); ++opIdx)
+    size_t GraphObj::getPeakLiveBytes(const OpVec &order) const
+    {
+        std::unordered_map<const OperatorObj *, size_t> steps;
+        steps.reserve(order.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            steps.emplace(order[i].get(), i);
+        // Difference array of live bytes over steps.
+        vector<long long> delta(order.size() + 1, 0);
+        for (const auto &op : order)
+            for (const auto &t : op->getOutputs())
             {
-                auto op = ops[opIdx];
-                if (!op || eraseOps.count(op.get()))
-                    continue;
-                if (op->getOpType() != OpType::MatMul)
-                    continue;
-                auto mm = std::dynamic_pointer_cast<MatmulObj>(op);
-                if (!mm)
-                    continue;
-
-                for (int inputIdx = 0; inputIdx < 2; ++inputIdx)
-                {
-                    auto in = op->inputs[inputIdx];
-                    if (!in)
-                        continue;
-                    auto pred = in->getSource();
-                    if (!pred || eraseOps.count(pred.get()) ||
-                        pred->getOpType() != OpType::Transpose)
-                        continue;
-
-                    // Only safe to fuse if transpose output is used only by this matmul.
-                    if (in->getTargets().size() != 1)
-                        continue;
-
-                    auto tp = std::dynamic_pointer_cast<TransposeObj>(pred);
-                    if (!tp)
-                        continue;
-                    const auto perm = tp->getPermute();
-                    const int rank = static_cast<int>(in->getRank());
-                    if (!is_swap_last_two(perm, rank))
-                        continue;
-
-                    auto orig = pred->inputs[0];
-                    if (!orig)
-                        continue;
-
-                    // Rewire matmul to consume transpose input directly.
-                    op->replaceInput(in, orig);
-                    in->removeTarget(op);
-                    orig->addTarget(op);
-
-                    // Update predecessor/successor relation.
-                    op->removePredecessors(pred);
-                    pred->removeSuccessors(op);
-                    if (auto origPred = orig->getSource())
-                    {
-                        origPred->addSuccessors(op);
-                        op->addPredecessors(origPred);
-                    }
+                size_t begin = steps.at(op.get()), end = begin;
+                if (isOutput(t))
+                    end = order.size() - 1;
+                for (auto *target : t->getTargetView())
+                    end = std::max(end, steps.at(target));
+                delta[begin] += t->getBytes();
+                delta[end + 1] -= t->getBytes();
+            }
+        long long live = 0, peak = 0;
+        for (auto d : delta)
+        {
+            live += d;
+            peak = std::max(peak, live);
+        }
+        return peak;
+    }
 
-                    // Toggle trans flag.
-                    if (inputIdx == 0)
-                        mm->setTransA(!mm->getTransA());
-                    else
-                        mm->setTransB(!mm->getTransB());
+    void GraphObj::optimize()
+    {
+        // =================================== 作业 ===================================
+        // TODO: 设计一个算法来实现指定的图优化规则
+        // 图优化规则如下：
+        // 1. 去除冗余的算子（例如，两个相邻的算子都是 transpose 算子，且做的是相反的操作，可以将其全部删除）
+        // 2. 合并算子（例如，矩阵乘算子中含有属性transA、transB，如果其输入存在transpose，且对最后两个维度做交换，就可以将transpose融入到矩阵乘算子的属性中去）
+        // =================================== 作业 ===================================
 
-                    // If transpose becomes unused, remove it.
-                    if (in->getTargets().empty())
-                    {
-                        detach_op(pred);
-                        eraseOps.insert(pred.get());
-                        changed = true;
-                    }
-                }
-            }
+        IT_ASSERT(topo_sort() == true);
+        eliminateDeadCode();
+        // The rules are registered in src/rules.
+        GraphRewriter(*this).run();
+        eliminateCommonSubexpressions();
+        foldConstants();
+    }
 
-            if (!eraseOps.empty())
+    namespace
+    {
+        struct KeyHash
+        {
+            size_t operator()(const vector<int64_t> &key) const
             {
-                ops.erase(std::remove_if(ops.begin(), ops.end(),
-                                         [&](const Operator &op)
-                                         {
-                                             return !op || eraseOps.count(op.get());
-                                         }),
-                          ops.end());
+                size_t seed = key.size();
+                for (auto v : key)
+                    seed ^= std::hash<int64_t>()(v) + 0x9e3779b97f4a7c15 +
+                            (seed << 6) + (seed >> 2);
+                return seed;
             }
+        };
+    } // namespace
 
-            // Rule 1: remove adjacent inverse Transpose pairs.
-            for (auto it = ops.begin(); it != ops.end();)
-            {
-                auto &op1 = *it;
-                if (op1->getOpType() != OpType::Transpose)
-                {
-                    ++it;
-                    continue;
-                }
-                auto t1 = std::dynamic_pointer_cast<TransposeObj>(op1);
-                if (!t1)
-                {
-                    ++it;
-                    continue;
-                }
-                auto y = op1->outputs[0];
-                if (!y || y->getTargets().size() != 1)
-                {
-                    ++it;
-                    continue;
-                }
-                auto op2 = y->getTargets()[0];
-                if (!op2 || op2->getOpType() != OpType::Transpose)
-                {
-                    ++it;
-                    continue;
-                }
-                auto t2 = std::dynamic_pointer_cast<TransposeObj>(op2);
-                if (!t2)
-                {
-                    ++it;
-                    continue;
-                }
-                auto z = op2->outputs[0];
-                if (!z)
-                {
-                    ++it;
-                    continue;
-                }
-                // Skip if z is a graph output (no targets) since we cannot safely
-                // replace external tensor references.
-                if (z->getTargets().empty())
-                {
-                    ++it;
-                    continue;
-                }
-
-                auto x = op1->inputs[0];
-                if (!x)
-                {
-                    ++it;
-                    continue;
-                }
-
-                const auto p1 = t1->getPermute();
-                const auto p2 = t2->getPermute();
-                const int rank = static_cast<int>(y->getRank());
-                if (!is_inverse_perm(p1, p2, rank))
-                {
-                    ++it;
-                    continue;
-                }
+    void GraphObj::setOutputs(const TensorVec &outputs)
+    {
+        for (const auto &t : outputs)
+        {
+            auto pos = findTensor(t->getFuid());
+            IT_ASSERT(pos && tensors[*pos] == t,
+                      "Output " + std::to_string(t->getGuid()) +
+                          " is not in the graph");
+        }
+        this->outputs = outputs;
+        outputSet.clear();
+        for (const auto &t : outputs)
+            outputSet.insert(t.get());
+        invalidatePlans();
+    }
 
-                // Rewire: replace uses of z with x.
-                auto succs = z->getTargets();
-                for (auto &succ : succs)
-                {
-                    succ->replaceInput(z, x);
-                    z->removeTarget(succ);
-                    x->addTarget(succ);
+    bool GraphObj::eliminateDeadCode()
+    {
+        if (outputs.empty())
+            return false;
+        IT_ASSERT(topo_sort() == true);
+        // Walk back from the outputs over producers.
+        std::unordered_set<const OperatorObj *> live;
+        vector<const OperatorObj *> stack;
+        for (const auto &t : outputs)
+            if (auto source = t->getSource(); source && live.insert(source.get()).second)
+                stack.emplace_back(source.get());
+        while (!stack.empty())
+        {
+            auto op = stack.back();
+            stack.pop_back();
+            for (auto *pred : op->getPredecessorView())
+                if (live.insert(pred).second)
+                    stack.emplace_back(pred);
+        }
+        // Consumers first, so that every erased op has no consumers left.
+        GraphRewriter rewriter(*this);
+        for (auto it = ops.rbegin(); it != ops.rend(); ++it)
+            if (!live.count(it->get()))
+                rewriter.eraseOperator(*it);
+        return rewriter.commit();
+    }
 
-                    succ->removePredecessors(op2);
-                    op2->removeSuccessors(succ);
-                    if (auto xp = x->getSource())
-                    {
-                        xp->addSuccessors(succ);
-                        succ->addPredecessors(xp);
-                    }
-                }
+    bool GraphObj::eliminateCommonSubexpressions()
+    {
+        IT_ASSERT(topo_sort() == true);
+        GraphRewriter rewriter(*this);
+        // (type, attributes, inputs) -> first op computing it. In topological
+        // order, the inputs of an op are already merged when it is visited,
+        // so chains of duplicates collapse in a single pass.
+        std::unordered_map<vector<int64_t>, Operator, KeyHash> seen;
+        seen.reserve(ops.size());
+        for (const auto &op : ops)
+        {
+            auto attributes = op->getAttributes();
+            if (!attributes)
+                continue;
+            vector<int64_t> key{op->getOpType().underlying(),
+                                int64_t(attributes->size())};
+            key.insert(key.end(), attributes->begin(), attributes->end());
+            for (const auto &input : op->getInputs())
+                key.emplace_back(reinterpret_cast<intptr_t>(input.get()));
+            auto [it, inserted] = seen.emplace(std::move(key), op);
+            if (inserted)
+                continue;
+            const auto &survivor = it->second;
+            // Graph outputs keep their producer.
+            bool producesOutput = false;
+            for (const auto &output : op->getOutputs())
+                producesOutput |= isOutput(output);
+            if (producesOutput)
+                continue;
+            for (size_t i = 0; i < op->getOutputs().size(); ++i)
+                rewriter.replaceAllUses(op->getOutput(i),
+                                        survivor->getOutput(i));
+            rewriter.eraseOperator(op);
+        }
+        return rewriter.commit();
+    }
 
-                // Remove the two transpose ops and their dangling tensors.
-                detach_op(op1);
-                detach_op(op2);
-                ops.erase(std::remove(ops.begin(), ops.end(), op1), ops.end());
-                ops.erase(std::remove(ops.begin(), ops.end(), op2), ops.end());
-                cleanup_dangling_tensors();
+    bool GraphObj::foldConstants()
+    {
+        IT_ASSERT(topo_sort() == true);
+        const auto &kernelRegistry = KernelRegistry::getInstance();
+        GraphRewriter rewriter(*this);
+        std::unordered_set<const TensorObj *> folded;
+        // Ops are visited in topological order, so constness propagates
+        // through chains of foldable ops in a single pass.
+        for (const auto &op : ops)
+        {
+            auto kernelAttrs =
+                KernelAttrs{runtime->getDevice(), op->getOpType().underlying()};
+            bool foldable = kernelRegistry.hasKernel(kernelAttrs);
+            for (const auto &input : op->getInputs())
+                foldable &= input && input->isWeight() && input->hasData();
+            // Graph outputs stay produced by the graph.
+            for (const auto &output : op->getOutputs())
+                foldable &= !isOutput(output);
+            if (!foldable)
+                continue;
 
-                changed = true;
-                // Restart since iterators invalidated.
-                it = ops.begin();
+            for (const auto &output : op->getOutputs())
+            {
+                constexpr std::align_val_t alignment{64};
+                void *ptr = ::operator new(output->getBytes(), alignment);
+                Ref<void> storage(ptr, [](void *p)
+                                  { ::operator delete(p, alignment); });
+                output->setDataBlob(make_ref<BlobObj>(runtime, ptr, storage));
             }
-
-            if (changed)
+            kernelRegistry.getKernel(kernelAttrs)->compute(op, runtime.get());
+            for (const auto &output : op->getOutputs())
             {
-                sorted = false;
-                IT_ASSERT(topo_sort() == true);
-                cleanup_dangling_tensors();
+                auto constant = addTensor(output->getDims(), output->getDType());
+                constant->setDataBlob(output->data);
+                constant->setWeight();
+                folded.insert(constant.get());
+                output->data = nullptr;
+                rewriter.replaceAllUses(output, constant);
             }
-        } while (changed);
+            rewriter.eraseOperator(op);
+        }
+        if (!rewriter.commit())
+            return false;
+        if (weightRegion)
+        {
+            TensorVec weights;
+            for (const auto &t : tensors)
+                if (t->isWeight() &&
+                    (folded.count(t.get()) || weightRegion->contains(t)))
+                    weights.emplace_back(t);
+            rebuildWeightRegion(weights);
+        }
+        return true;
     }
 
     Tensor GraphObj::getTensor(int fuid) const
     {
-        for (auto tensor : tensors)
-        {
-            if (tensor->getFuid() == fuid)
-            {
-                return tensor;
-            }
-        }
-        return nullptr;
+        auto pos = findTensor(fuid);
+        return pos ? tensors[*pos] : nullptr;
     }
 
-    void GraphObj::shape_infer()
+    size_t GraphObj::shape_infer()
     {
-        for (auto &op : ops)
+        IT_ASSERT(topo_sort() == true);
+        // Re-infers an op and returns the outputs whose shapes changed.
+        auto infer = [](OperatorObj *op)
         {
             auto ans = op->inferShape();
             IT_ASSERT(ans.has_value());
-            auto oldOutputs = op->getOutputs();
+            const auto &oldOutputs = op->getOutputs();
             IT_ASSERT(ans.value().size() == oldOutputs.size());
+            TensorVec changed;
             // replace the old outputshape and size with new one
-            for (int i = 0; i < (int)ans.value().size(); ++i)
+            for (size_t i = 0; i < ans.value().size(); ++i)
             {
-                auto newShape = ans.value()[i];
-                auto oldShape = oldOutputs[i]->getDims();
-                auto fuid = oldOutputs[i]->getFuid();
-                if (newShape != oldShape)
+                if (ans.value()[i] != oldOutputs[i]->getDims())
                 {
-                    auto tensor = this->getTensor(fuid);
-                    tensor->setShape(newShape);
+                    oldOutputs[i]->setShape(ans.value()[i]);
+                    changed.emplace_back(oldOutputs[i]);
                 }
             }
+            return changed;
+        };
+
+        if (inferredInputShapes.empty())
+        {
+            for (auto &op : ops)
+                infer(op.get());
+            for (const auto &t : tensors)
+                if (!t->getSource())
+                    inferredInputShapes.emplace_back(t, t->getDims());
+            return ops.size();
+        }
+
+        // Ops consuming changed tensors, visited in topological order.
+        std::priority_queue<size_t, vector<size_t>, std::greater<size_t>> queue;
+        std::unordered_set<const OperatorObj *> queued;
+        auto enqueueConsumers = [&](const Tensor &t)
+        {
+            for (auto *op : t->getTargetView())
+                if (queued.insert(op).second)
+                    queue.push(findOperator(op).value());
+        };
+        for (auto &[t, shape] : inferredInputShapes)
+            if (t->getDims() != shape)
+            {
+                shape = t->getDims();
+                enqueueConsumers(t);
+            }
+        size_t visited = 0;
+        for (; !queue.empty(); ++visited)
+        {
+            auto op = ops[queue.top()];
+            queue.pop();
+            for (const auto &t : infer(op.get()))
+                enqueueConsumers(t);
+        }
+        if (visited > 0)
+            dimBindings.reset();
+        return visited;
+    }
+
+    void GraphObj::inferSymbolicShapes()
+    {
+        IT_ASSERT(topo_sort() == true);
+        for (const auto &t : tensors)
+            if (!t->getSource() && !t->getSymbolicShape())
+                t->setSymbolicShape(toSymShape(t->getDims()));
+        vector<SymShape> inputs;
+        for (const auto &op : ops)
+        {
+            inputs.clear();
+            for (const auto &input : op->getInputs())
+                inputs.emplace_back(*input->getSymbolicShape());
+            auto ans = op->inferSymbolicShape(inputs);
+            IT_ASSERT(ans && ans->size() == op->getOutputs().size(),
+                      "Cannot infer symbolic shapes of " + op->toString());
+            for (size_t i = 0; i < ans->size(); ++i)
+                op->getOutput(i)->setSymbolicShape(std::move((*ans)[i]));
+        }
+        // The next plan is compiled with the new shapes.
+        invalidatePlans();
+    }
+
+    void GraphObj::bindDims(const SymBindings &bindings)
+    {
+        for (const auto &t : tensors)
+        {
+            const auto &symbolic = t->getSymbolicShape();
+            IT_ASSERT(symbolic, "Tensor " + std::to_string(t->getGuid()) +
+                                    " has no symbolic shape, call "
+                                    "inferSymbolicShapes after changing the graph");
+            auto dims = evaluate(*symbolic, bindings);
+            if (dims != t->getDims())
+                t->setShape(std::move(dims));
         }
+        // shape_infer has nothing left to do.
+        for (auto &[t, shape] : inferredInputShapes)
+            shape = t->getDims();
+        dimBindings = bindings;
     }
 
     void GraphObj::dataMalloc()
     {
         // topological sorting first
         IT_ASSERT(topo_sort() == true);
+        if (!memoryOrdered)
+            reorderForMemory();
         // =================================== 作业 ===================================
         // TODO：利用 allocator 给计算图分配内存
         // HINT: 获取分配好的内存指针后，可以调用 tensor 的 setDataBlob 函数给 tensor 绑定内存
         // =================================== 作业 ===================================
 
-        // Pass 1: simulate allocation to compute offsets and peak memory.
-        std::unordered_map<TensorObj *, size_t> offsetMap;
-        std::unordered_map<TensorObj *, size_t> remainingUses;
-        std::unordered_set<TensorObj *> pinned;
+        schedule();
+        // Weights are placed once and never re-planned.
+        bindWeights();
 
-        pinned.reserve(tensors.size());
-        remainingUses.reserve(tensors.size());
-        offsetMap.reserve(tensors.size());
+        // Pass 1: plan offsets offline over the tensor lifetimes, once per
+        // distinct input-shape signature.
+        auto signature = getInputSignature();
+        auto cached = planCache.find(signature);
+        if (cached == planCache.end() && symbolicPlan && dimBindings)
+        {
+            // Shapes set by bindDims: no planning on the request path.
+            cached = planCache.emplace(std::move(signature),
+                                       symbolicPlan->evaluate(*dimBindings))
+                         .first;
+        }
+        else if (cached == planCache.end())
+        {
+            auto plan = planMemory();
+            if (memoryBudget > 0 && plan.peak > memoryBudget)
+                plan = rematerialize(std::move(plan));
+            // A budget or offloading depends on the sizes, so only plans
+            // without them carry over to other bindings.
+            if (memoryBudget == 0 && !offloadOptions)
+                symbolicPlan = compileSymbolicPlan(plan);
+            cached = planCache.emplace(std::move(signature), std::move(plan)).first;
+        }
+        memoryPlan = cached->second;
 
-        // Pin graph inputs/outputs: keep their storage alive.
-        for (const auto &t : tensors)
+        // Pass 2: reserve the planned arena as a single block, then bind each
+        // tensor's blob.
+        allocator.reset();
+        if (memoryPlan.peak > 0)
+            allocator.alloc(memoryPlan.peak);
+        void *base = allocator.getPtr();
+        tensorOffsets.clear();
+        tensorOffsets.reserve(memoryPlan.intervals.size());
+        for (size_t i = 0; i < memoryPlan.intervals.size(); ++i)
         {
-            if (!t)
+            const auto &t = memoryPlan.intervals[i].tensor;
+            auto offset = memoryPlan.offsets[i];
+            // Offloaded tensors start in their first interval.
+            if (!tensorOffsets.emplace(t.get(), offset).second)
                 continue;
-            if (!t->getSource() || t->getTargets().empty())
-                pinned.insert(t.get());
-            remainingUses.emplace(t.get(), t->getTargets().size());
+            auto ptr = static_cast<void *>(static_cast<char *>(base) + offset);
+            t->setDataBlob(make_ref<BlobObj>(runtime, ptr));
         }
+        offloader = offloadOptions ? makeOffloader(base) : nullptr;
+    }
+
+    void GraphObj::invalidatePlans()
+    {
+        memoryOrdered = false;
+        planCache.clear();
+        symbolicPlan.reset();
+        dimBindings.reset();
+    }
 
-        // Allocate graph inputs first (they have no source op).
+    optional<SymbolicPlan>
+    GraphObj::compileSymbolicPlan(const MemoryPlan &plan) const
+    {
+        vector<SymExpr> sizes;
+        sizes.reserve(plan.intervals.size());
+        for (const auto &interval : plan.intervals)
+        {
+            const auto &t = interval.tensor;
+            if (!t->getSymbolicShape())
+                return std::nullopt;
+            sizes.emplace_back(getNumElements(*t->getSymbolicShape()) *
+                               SymExpr(t->getDType().getSize()));
+        }
+        return SymbolicPlan(plan, std::move(sizes), allocator.getAlignment());
+    }
+
+    vector<Shape> GraphObj::getInputSignature() const
+    {
+        vector<Shape> signature;
         for (const auto &t : tensors)
+            if (!t->getSource() && !t->isWeight())
+                signature.emplace_back(t->getDims());
+        return signature;
+    }
+
+    MemoryPlan GraphObj::planMemory() const
+    {
+        IT_ASSERT(sorted && !stages.empty() && stages.back() == ops.size(),
+                  "The graph must be scheduled before planning");
+        // Step i executes stage i. A tensor lives from the stage producing it
+        // to the stage of its last consumer. Graph inputs and outputs are
+        // pinned for the whole run.
+        const int lastStep = std::max<int>(stages.size() - 1, 1) - 1;
+        auto steps = getOpStages();
+
+        MemoryPlanner planner(allocator.getAlignment());
+        // Graph inputs first, so that the online replay places them at the
+        // bottom of the arena.
+        // Offloaded tensors get one interval per span they are resident.
+        // Graph inputs stay resident: callers write into them between runs.
+        auto addTensor = [&](const Tensor &t, int begin, int end)
         {
-            if (!t)
-                continue;
-            if (!t->getSource())
+            if (!offloadOptions || !t->getSource() ||
+                t->getBytes() < offloadOptions->minBytes)
             {
-                auto off = allocator.alloc(t->getBytes());
-                offsetMap.emplace(t.get(), off);
+                planner.addInterval(t, t->getBytes(), begin, end);
+                return;
             }
+            vector<int> uses;
+            for (auto *target : t->getTargetView())
+                uses.emplace_back(steps.at(target));
+            std::sort(uses.begin(), uses.end());
+            for (auto [first, last] :
+                 OffloaderObj::split(*offloadOptions, begin, end, uses))
+                planner.addInterval(t, t->getBytes(), first, last);
+        };
+        for (const auto &t : tensors)
+            if (t && !t->getSource() && !t->isWeight())
+                addTensor(t, 0, lastStep);
+        for (const auto &t : tensors)
+        {
+            if (!t || !t->getSource())
+                continue;
+            int begin = steps.at(t->getSource().get());
+            int end = begin;
+            if (isOutput(t))
+                end = lastStep;
+            for (auto *target : t->getTargetView())
+                end = std::max(end, steps.at(target));
+            addTensor(t, begin, end);
         }
+        return planner.solve(MemoryPlanner::allStrategies());
+    }
 
-        // Allocate outputs when produced; free intermediates after last use.
+    MemoryPlanReport GraphObj::getMemoryReport() const
+    {
+        IT_ASSERT(sorted && !stages.empty(),
+                  "The graph has changed since dataMalloc");
+        auto report = makeReport(memoryPlan, stages.size() - 1);
+        for (size_t stage = 0; stage + 1 < stages.size(); ++stage)
+            for (size_t i = stages[stage]; i < stages[stage + 1]; ++i)
+            {
+                auto &name = report.ops[stage];
+                name += (name.empty() ? "" : "+");
+                name += ops[i]->getOpType().toString();
+            }
+        return report;
+    }
+
+    void GraphObj::setParallelism(int parallelism)
+    {
+        IT_ASSERT(parallelism >= 1);
+        if (parallelism == this->parallelism)
+            return;
+        this->parallelism = parallelism;
+        stages.clear();
+        invalidatePlans();
+    }
+
+    void GraphObj::schedule()
+    {
+        IT_ASSERT(sorted);
+        stages.clear();
+        if (parallelism == 1)
+        {
+            // One op per stage, in topological order.
+            for (size_t i = 0; i <= ops.size(); ++i)
+                stages.emplace_back(i);
+            return;
+        }
+        // Place each op at the earliest level after all its producers, except
+        // recomputing ops, which go right before their earliest consumer.
+        std::unordered_map<const OperatorObj *, size_t> levels;
         for (const auto &op : ops)
         {
-            // Allocate op outputs
-            for (const auto &out : op->getOutputs())
+            size_t level = 0;
+            for (auto *pred : op->getPredecessorView())
+                level = std::max(level, levels.at(pred) + 1);
+            levels.emplace(op.get(), level);
+        }
+        for (auto it = ops.rbegin(); it != ops.rend(); ++it)
+        {
+            const auto &op = *it;
+            auto successors = op->getSuccessorView();
+            if (!recomputeOps.count(op->getGuid()) || successors.empty())
+                continue;
+            size_t level = levels.at(successors[0]);
+            for (auto *succ : successors)
+                level = std::min(level, levels.at(succ));
+            levels[op.get()] = level - 1;
+        }
+        // Split levels wider than the parallelism into several stages.
+        vector<OpVec> byLevel;
+        for (const auto &op : ops)
+        {
+            size_t level = levels.at(op.get());
+            if (byLevel.size() <= level)
+                byLevel.resize(level + 1);
+            byLevel[level].emplace_back(op);
+        }
+        ops.clear();
+        for (const auto &level : byLevel)
+            for (size_t i = 0; i < level.size(); ++i)
             {
-                if (!out)
-                    continue;
-                if (offsetMap.find(out.get()) == offsetMap.end())
-                {
-                    auto off = allocator.alloc(out->getBytes());
-                    offsetMap.emplace(out.get(), off);
-                }
+                if (i % parallelism == 0)
+                    stages.emplace_back(ops.size());
+                ops.emplace_back(level[i]);
             }
+        stages.emplace_back(ops.size());
+    }
 
-            // Consume op inputs; free when no longer needed.
-            for (const auto &in : op->getInputs())
+    std::unordered_map<const OperatorObj *, int> GraphObj::getOpStages() const
+    {
+        std::unordered_map<const OperatorObj *, int> stageOf;
+        stageOf.reserve(ops.size());
+        for (size_t stage = 0; stage + 1 < stages.size(); ++stage)
+            for (size_t i = stages[stage]; i < stages[stage + 1]; ++i)
+                stageOf.emplace(ops[i].get(), stage);
+        return stageOf;
+    }
+
+    void GraphObj::setOffloadOptions(optional<OffloadOptions> options)
+    {
+        IT_ASSERT(!options || options->minIdleSteps >= 2,
+                  "Offloading needs idle spans of at least 2 steps");
+        offloadOptions = std::move(options);
+        offloader = nullptr;
+        invalidatePlans();
+    }
+
+    Offloader GraphObj::makeOffloader(void *base) const
+    {
+        auto steps = getOpStages();
+        // The intervals of a tensor are consecutive and sorted by time.
+        vector<pair<Tensor, vector<OffloaderObj::Segment>>> offloaded;
+        const auto &intervals = memoryPlan.intervals;
+        for (size_t i = 0; i < intervals.size(); ++i)
+        {
+            const auto &t = intervals[i].tensor;
+            if (i + 1 == intervals.size() || intervals[i + 1].tensor != t)
+                continue;
+            vector<OffloaderObj::Segment> segments;
+            for (; i < intervals.size() && intervals[i].tensor == t; ++i)
             {
-                if (!in)
-                    continue;
-                auto *tp = in.get();
-                if (pinned.find(tp) != pinned.end())
-                    continue;
-                auto it = remainingUses.find(tp);
-                IT_ASSERT(it != remainingUses.end());
-                IT_ASSERT(it->second > 0);
-                it->second--;
-                if (it->second == 0)
+                int begin = intervals[i].begin, firstUse = intervals[i].end;
+                for (auto *target : t->getTargetView())
                 {
-                    auto offIt = offsetMap.find(tp);
-                    IT_ASSERT(offIt != offsetMap.end());
-                    allocator.free(offIt->second, in->getBytes());
+                    int step = steps.at(target);
+                    if (step >= begin)
+                        firstUse = std::min(firstUse, step);
                 }
+                auto ptr = static_cast<char *>(base) + memoryPlan.offsets[i];
+                segments.push_back({ptr, begin, intervals[i].end, firstUse});
             }
+            --i;
+            offloaded.emplace_back(t, std::move(segments));
         }
+        if (offloaded.empty())
+            return nullptr;
+        return make_ref<OffloaderObj>(runtime, *offloadOptions,
+                                      std::move(offloaded));
+    }
 
-        // Pass 2: allocate the real arena once, then bind each tensor's blob.
-        void *base = allocator.getPtr();
+    void GraphObj::setMemoryBudget(size_t bytes)
+    {
+        if (bytes == memoryBudget)
+            return;
+        memoryBudget = bytes;
+        invalidatePlans();
+    }
+
+    MemoryPlan GraphObj::rematerialize(MemoryPlan plan)
+    {
+        // Every round frees one tensor at the peak step; bound the rounds in
+        // case freeing keeps moving the peak around.
+        const size_t maxRounds = 2 * ops.size();
+        // Adding and removing the recomputing ops drops the plans, but they
+        // are scheduled next to their uses, so the order stays good for
+        // memory.
+        const bool ordered = memoryOrdered;
+        vector<pair<Operator, Tensor>> added;
+        for (size_t round = 0; round < maxRounds && plan.peak > memoryBudget;
+             ++round)
+        {
+            auto report = makeReport(plan, stages.size() - 1);
+            auto recompute = recomputeAcross(report.peakStep);
+            if (!recompute.first)
+                break;
+            added.emplace_back(std::move(recompute));
+            schedule();
+            plan = planMemory();
+        }
+        if (plan.peak > memoryBudget)
+        {
+            // Leave the graph as it was.
+            for (auto it = added.rbegin(); it != added.rend(); ++it)
+                undoRecompute(it->first, it->second);
+            schedule();
+            memoryOrdered = ordered;
+            IT_ASSERT(false, "Cannot fit the activations in the memory budget of " +
+                                 std::to_string(memoryBudget) + " bytes, " +
+                                 std::to_string(plan.peak) + " bytes needed");
+        }
+        memoryOrdered = ordered;
+        return plan;
+    }
+
+    void GraphObj::undoRecompute(const Operator &recompute,
+                                 const Tensor &original)
+    {
+        auto copy = recompute->getOutput();
+        auto source = original->getSource();
+        for (const auto &op : copy->getTargets())
+        {
+            if (std::find(op->inputs.begin(), op->inputs.end(), copy) ==
+                op->inputs.end())
+                continue;
+            copy->removeTarget(op);
+            op->removePredecessors(recompute);
+            recompute->removeSuccessors(op);
+            for (const auto &input : op->getInputs())
+                if (input == copy)
+                {
+                    original->addTarget(op);
+                    op->addPredecessors(source);
+                    source->addSuccessors(op);
+                }
+            op->replaceInput(copy, original);
+        }
+        removeOperator(recompute);
+        removeTensor(copy);
+    }
+
+    pair<Operator, Tensor> GraphObj::recomputeAcross(int peakStep)
+    {
+        auto isCheap = [](OpType type)
+        {
+            switch (type.underlying())
+            {
+            case OpType::Add:
+            case OpType::Sub:
+            case OpType::Mul:
+            case OpType::Div:
+            case OpType::Relu:
+            case OpType::Clip:
+            case OpType::Cast:
+            case OpType::Transpose:
+                return true;
+            default:
+                return false;
+            }
+        };
+        auto stageOf = getOpStages();
+        auto lastUse = [&](const Tensor &t)
+        {
+            int last = -1;
+            for (auto *target : t->getTargetView())
+                last = std::max(last, stageOf.at(target));
+            return last;
+        };
+
+        // Split every candidate's uses at the peak: the tensor is freed after
+        // its last use before the peak and produced again before its first
+        // use after it.
+        Tensor best;
+        int bestSplit = -1;
+        double bestScore = 0;
         for (const auto &t : tensors)
         {
-            if (!t)
+            auto source = t->getSource();
+            if (!source || !isCheap(source->getOpType()) ||
+                source->getOutputs().size() != 1 || isOutput(t))
+                continue;
+            int before = stageOf.at(source.get()), after = -1;
+            for (auto *target : t->getTargetView())
+            {
+                int stage = stageOf.at(target);
+                if (stage <= peakStep)
+                    before = std::max(before, stage);
+                else if (after < 0 || stage < after)
+                    after = stage;
+            }
+            if (before >= peakStep || after < 0)
                 continue;
-            auto it = offsetMap.find(t.get());
-            if (it == offsetMap.end())
+            // The recomputation must not extend the lifetime of its inputs.
+            bool inputsLive = true;
+            for (const auto &input : source->getInputs())
+                if (input->getSource() && lastUse(input) < after)
+                    inputsLive = false;
+            if (!inputsLive)
                 continue;
-            auto ptr = static_cast<void *>(static_cast<char *>(base) + it->second);
+            double cost = std::max(
+                runtime->getMachineModel().predictNs(source->getCost()), 1e-3);
+            double score = double(t->getBytes()) * (after - before - 1) / cost;
+            if (score > bestScore)
+                best = t, bestSplit = after, bestScore = score;
+        }
+        if (!best)
+            return {nullptr, nullptr};
+
+        auto source = best->getSource();
+        OpVec later;
+        for (const auto &target : best->getTargets())
+            if (stageOf.at(target.get()) >= bestSplit &&
+                std::find(later.begin(), later.end(), target) == later.end())
+                later.emplace_back(target);
+        Tensor copy = addTensor(best->getDims(), best->getDType());
+        auto recompute = source->clone(source->getInputs(), {copy});
+        addOperatorAndConnect(recompute);
+        recomputeOps.insert(recompute->getGuid());
+        for (const auto &op : later)
+        {
+            for (const auto &input : op->getInputs())
+                if (input == best)
+                {
+                    best->removeTarget(op);
+                    copy->addTarget(op);
+                }
+            op->replaceInput(best, copy);
+            op->removePredecessors(source);
+            source->removeSuccessors(op);
+            op->addPredecessors(recompute);
+            recompute->addSuccessors(op);
+        }
+
+        // Keep the topological order: run the recomputation right before the
+        // first later use.
+        ops.pop_back();
+        size_t first = ops.size();
+        for (const auto &op : later)
+            first = std::min<size_t>(
+                first, std::find(ops.begin(), ops.end(), op) - ops.begin());
+        ops.insert(ops.begin() + first, recompute);
+        sorted = true;
+        return {recompute, best};
+    }
+
+    void GraphObj::bindWeights()
+    {
+        TensorVec weights;
+        for (const auto &t : tensors)
+            if (t->isWeight() && !t->hasData())
+                weights.emplace_back(t);
+        if (weights.empty())
+            return;
+        if (!weightRegion)
+            weightRegion = make_ref<WeightRegionObj>(runtime, weights,
+                                                     allocator.getAlignment());
+        else if (std::any_of(weights.begin(), weights.end(),
+                             [&](const Tensor &t)
+                             { return !weightRegion->contains(t); }))
+        {
+            // Weights added since the region was laid out.
+            TensorVec all;
+            for (const auto &t : tensors)
+                if (t->isWeight() &&
+                    (!t->hasData() || weightRegion->contains(t)))
+                    all.emplace_back(t);
+            rebuildWeightRegion(all);
+            return;
+        }
+        for (const auto &t : weights)
+            t->setDataBlob(make_ref<BlobObj>(runtime, weightRegion->getPtr(t)));
+    }
+
+    void GraphObj::rebuildWeightRegion(const TensorVec &weights)
+    {
+        auto region = make_ref<WeightRegionObj>(runtime, weights,
+                                                allocator.getAlignment());
+        for (const auto &t : weights)
+        {
+            void *ptr = region->getPtr(t);
+            if (t->hasData())
+                std::memcpy(ptr, t->getRawDataPtr<void *>(), t->getBytes());
+            else if (weightRegion && weightRegion->contains(t))
+                std::memcpy(ptr, weightRegion->getPtr(t), t->getBytes());
             t->setDataBlob(make_ref<BlobObj>(runtime, ptr));
         }
+        weightRegion = region;
+    }
 
-        allocator.info();
+    void GraphObj::setWeightRegion(const WeightRegion &region)
+    {
+        IT_ASSERT(region->getRuntime() == runtime,
+                  "Weight region belongs to another runtime");
+        weightRegion = region;
     }
 
     Tensor GraphObj::addTensor(Shape dim, DataType dtype)
     {
-        tensors.emplace_back(make_ref<TensorObj>(dim, dtype, runtime));
-        return tensors.back();
+        invalidatePlans();
+        auto tensor = makeNode<TensorObj>(dim, dtype, runtime);
+        tensorIndex[tensor->getFuid()] = tensors.size();
+        tensors.emplace_back(tensor);
+        return tensor;
     }
 
     Tensor GraphObj::addTensor(const Tensor &tensor)
@@ -512,6 +1129,8 @@ namespace infini
                   std::string("Tensor runtime mismatch: cannot add a tenosr in ") +
                       tensor->getRuntime()->toString() + " to " +
                       runtime->toString());
+        invalidatePlans();
+        tensorIndex[tensor->getFuid()] = tensors.size();
         tensors.emplace_back(tensor);
         return tensor;
     }
@@ -529,46 +1148,52 @@ namespace infini
     // "predecessors" and "successors" of an operator of "ops" must be in "ops".
     bool GraphObj::checkValid() const
     {
-        for (auto tensor : tensors)
+        std::unordered_set<const OperatorObj *> opSet;
+        opSet.reserve(ops.size());
+        for (const auto &op : ops)
+            opSet.insert(op.get());
+        std::unordered_set<const TensorObj *> tensorSet;
+        // check whether two tensors with the same FUID exist
+        std::unordered_set<UidBaseType> fuids;
+        tensorSet.reserve(tensors.size());
+        fuids.reserve(tensors.size());
+        for (const auto &tensor : tensors)
+        {
+            tensorSet.insert(tensor.get());
+            IT_ASSERT(fuids.insert(tensor->getFuid()).second,
+                      std::to_string(tensor->getFuid()));
+        }
+
+        for (const auto &tensor : tensors)
         {
-            IT_ASSERT(!(tensor->getTargets().size() == 0 &&
+            IT_ASSERT(!(tensor->getTargetView().empty() &&
                         nullptr == tensor->getSource()));
-            for (auto op : tensor->getTargets())
+            for (auto *op : tensor->getTargetView())
             {
-                IT_ASSERT(std::find(ops.begin(), ops.end(), op) != ops.end());
+                IT_ASSERT(opSet.count(op));
             }
             auto op = tensor->getSource();
-            IT_ASSERT(!(op && std::find(ops.begin(), ops.end(), op) == ops.end()));
+            IT_ASSERT(!(op && !opSet.count(op.get())));
         }
-        for (auto op : ops)
+        for (const auto &op : ops)
         {
-            for (auto tensor : op->getInputs())
+            for (const auto &tensor : op->getInputs())
             {
-                IT_ASSERT(std::find(tensors.begin(), tensors.end(), tensor) !=
-                          tensors.end());
+                IT_ASSERT(tensorSet.count(tensor.get()));
             }
-            for (auto tensor : op->getOutputs())
+            for (const auto &tensor : op->getOutputs())
             {
-                IT_ASSERT(std::find(tensors.begin(), tensors.end(), tensor) !=
-                          tensors.end());
+                IT_ASSERT(tensorSet.count(tensor.get()));
             }
-            for (auto pre : op->getPredecessors())
+            for (auto *pre : op->getPredecessorView())
             {
-                IT_ASSERT(std::find(ops.begin(), ops.end(), pre) != ops.end());
+                IT_ASSERT(opSet.count(pre));
             }
-            for (auto suc : op->getSuccessors())
+            for (auto *suc : op->getSuccessorView())
             {
-                IT_ASSERT(std::find(ops.begin(), ops.end(), suc) != ops.end());
+                IT_ASSERT(opSet.count(suc));
             }
         }
-        std::set<UidBaseType> s;
-        // check whether two tensors with the same FUID exist
-        for (auto tensor : tensors)
-        {
-            int cnt = s.count(tensor->getFuid());
-            IT_ASSERT(cnt == 0, std::to_string(tensor->getFuid()));
-            s.insert(tensor->getFuid());
-        }
         return true;
     }
 
@@ -0,0 +1,212 @@
+#include "core/machine_model.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace infini
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        double elapsedNs(Clock::time_point begin)
+        {
+            return std::chrono::duration<double, std::nano>(Clock::now() -
+                                                            begin)
+                .count();
+        }
+    } // namespace
+
+    double MachineModel::predictNs(const OpCost &cost, int threads) const
+    {
+        IT_ASSERT(threads >= 1);
+        double serial =
+            std::max(cost.flops / flopsPerNs, cost.getBytes() / bytesPerNs);
+        if (threads == 1)
+            return serial;
+        return serial / threads + forkJoinNs * threads / maxThreads;
+    }
+
+    int MachineModel::threadsFor(const OpCost &cost) const
+    {
+        int best = 1;
+        double bestTime = predictNs(cost);
+        for (int p = 2; p <= maxThreads; ++p)
+        {
+            double time = predictNs(cost, p);
+            if (time < bestTime)
+            {
+                best = p;
+                bestTime = time;
+            }
+        }
+        return best;
+    }
+
+    MachineModel MachineModel::calibrate()
+    {
+        MachineModel model;
+#ifdef _OPENMP
+        model.maxThreads = std::max(1, omp_get_max_threads());
+#endif
+
+        // Bandwidth: scaling a buffer well beyond the caches in place, which
+        // reads and writes every element.
+        constexpr size_t large = 1 << 22;
+        vector<float> buffer(large, 1.f);
+        double best = -1;
+        for (int rep = 0; rep < 3; ++rep)
+        {
+            auto begin = Clock::now();
+            for (size_t i = 0; i < large; ++i)
+                buffer[i] *= 0.5f;
+            double ns = elapsedNs(begin);
+            if (best < 0 || ns < best)
+                best = ns;
+        }
+        volatile float sink = buffer[large / 2];
+        model.bytesPerNs = 2 * sizeof(float) * large / std::max(best, 1.);
+
+        // Throughput: independent multiply-add chains held in registers.
+        constexpr int chains = 8, steps = 1 << 16;
+        float acc[chains];
+        best = -1;
+        for (int rep = 0; rep < 3; ++rep)
+        {
+            std::fill(acc, acc + chains, 1.f);
+            auto begin = Clock::now();
+            for (int i = 0; i < steps; ++i)
+                for (int c = 0; c < chains; ++c)
+                    acc[c] = acc[c] * 0.999f + 0.001f;
+            double ns = elapsedNs(begin);
+            if (best < 0 || ns < best)
+                best = ns;
+        }
+        sink = acc[0] + acc[chains - 1];
+        (void)sink;
+        model.flopsPerNs = 2. * chains * steps / std::max(best, 1.);
+
+#ifdef _OPENMP
+        if (model.maxThreads > 1)
+        {
+            constexpr int regions = 64;
+            // Warm up the thread pool before timing.
+#pragma omp parallel num_threads(model.maxThreads)
+            {
+            }
+            auto begin = Clock::now();
+            for (int i = 0; i < regions; ++i)
+            {
+#pragma omp parallel num_threads(model.maxThreads)
+                {
+                }
+            }
+            model.forkJoinNs = elapsedNs(begin) / regions;
+        }
+#endif
+        return model;
+    }
+
+    MachineModel MachineModel::loadOrCalibrate(const string &path)
+    {
+        if (!path.empty())
+            if (auto model = load(path))
+                return *model;
+        auto model = calibrate();
+        if (!path.empty())
+            model.save(path);
+        return model;
+    }
+
+    MachineModel MachineModel::loadOrCalibrate()
+    {
+        auto path = getDefaultPath();
+        if (path.empty())
+            return calibrate();
+        auto model = load(path);
+#ifdef _OPENMP
+        if (model && model->maxThreads != std::max(1, omp_get_max_threads()))
+            model.reset();
+#endif
+        if (model)
+            return *model;
+        std::error_code ec;
+        std::filesystem::create_directories(
+            std::filesystem::path(path).parent_path(), ec);
+        auto calibrated = calibrate();
+        calibrated.save(path);
+        return calibrated;
+    }
+
+    string MachineModel::getDefaultPath()
+    {
+        if (const char *path = std::getenv("INFINI_MACHINE_MODEL"))
+            return path;
+        string cache;
+        if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+            cache = xdg;
+        else if (const char *home = std::getenv("HOME"); home && *home)
+            cache = string(home) + "/.cache";
+        else
+            return "";
+        return cache + "/infinitensor/machine_model.txt";
+    }
+
+    bool MachineModel::save(const string &path) const
+    {
+        std::ofstream ofs(path);
+        if (!ofs)
+            return false;
+        ofs << "maxThreads " << maxThreads << "\n";
+        ofs << "forkJoinNs " << forkJoinNs << "\n";
+        ofs << "bytesPerNs " << bytesPerNs << "\n";
+        ofs << "flopsPerNs " << flopsPerNs << "\n";
+        return static_cast<bool>(ofs);
+    }
+
+    optional<MachineModel> MachineModel::load(const string &path)
+    {
+        std::ifstream ifs(path);
+        if (!ifs)
+            return std::nullopt;
+        MachineModel model;
+        // Files written before a constant existed are recalibrated.
+        model.bytesPerNs = model.flopsPerNs = 0;
+        string key;
+        while (ifs >> key)
+        {
+            if (key == "maxThreads")
+                ifs >> model.maxThreads;
+            else if (key == "forkJoinNs")
+                ifs >> model.forkJoinNs;
+            else if (key == "bytesPerNs")
+                ifs >> model.bytesPerNs;
+            else if (key == "flopsPerNs")
+                ifs >> model.flopsPerNs;
+            else
+                return std::nullopt;
+            if (!ifs)
+                return std::nullopt;
+        }
+        if (model.maxThreads < 1 || model.bytesPerNs <= 0 ||
+            model.flopsPerNs <= 0)
+            return std::nullopt;
+        return model;
+    }
+
+    string MachineModel::toString() const
+    {
+        std::ostringstream oss;
+        oss << "MachineModel(maxThreads=" << maxThreads
+            << ", forkJoinNs=" << forkJoinNs
+            << ", bytesPerNs=" << bytesPerNs << ", flopsPerNs=" << flopsPerNs
+            << ")";
+        return oss.str();
+    }
+
+} // namespace infini
@@ -0,0 +1,462 @@
+#include "core/memory_planner.h"
+#include "core/allocator.h"
+#include <algorithm>
+#include <map>
+#include <numeric>
+
+namespace infini
+{
+    namespace
+    {
+        /**
+         * @brief Intervals indexed by step. The ones overlapping [begin, end]
+         * either contain `begin`, found by a stabbing query on a segment tree
+         * over steps holding each interval at its canonical nodes, or start
+         * inside (begin, end]. A query costs O(log steps + overlaps).
+         */
+        class StepIndex
+        {
+            int first;
+            size_t leaves = 1;
+            vector<vector<size_t>> nodes;
+            std::multimap<int, size_t> byBegin;
+
+        public:
+            StepIndex(int first, int last) : first(first)
+            {
+                while (leaves < size_t(last - first + 1))
+                    leaves *= 2;
+                nodes.resize(2 * leaves);
+            }
+
+            void insert(size_t idx, const LiveInterval &interval)
+            {
+                for (size_t lo = leaves + (interval.begin - first),
+                            hi = leaves + (interval.end - first) + 1;
+                     lo < hi; lo /= 2, hi /= 2)
+                {
+                    if (lo & 1)
+                        nodes[lo++].emplace_back(idx);
+                    if (hi & 1)
+                        nodes[--hi].emplace_back(idx);
+                }
+                byBegin.emplace(interval.begin, idx);
+            }
+
+            template <typename F>
+            void forEachOverlap(const LiveInterval &interval, F &&f) const
+            {
+                for (size_t node = leaves + (interval.begin - first); node > 0;
+                     node /= 2)
+                    for (auto idx : nodes[node])
+                        f(idx);
+                for (auto it = byBegin.upper_bound(interval.begin);
+                     it != byBegin.end() && it->first <= interval.end; ++it)
+                    f(it->second);
+            }
+        };
+
+        StepIndex makeStepIndex(const vector<LiveInterval> &intervals)
+        {
+            int first = intervals[0].begin, last = intervals[0].end;
+            for (const auto &interval : intervals)
+            {
+                first = std::min(first, interval.begin);
+                last = std::max(last, interval.end);
+            }
+            return StepIndex(first, last);
+        }
+    } // namespace
+
+    const char *toString(PlanStrategy strategy)
+    {
+        switch (strategy)
+        {
+        case PlanStrategy::OnlineBestFit:
+            return "OnlineBestFit";
+        case PlanStrategy::GreedyBySize:
+            return "GreedyBySize";
+        case PlanStrategy::GreedyByBreadth:
+            return "GreedyByBreadth";
+        case PlanStrategy::BestFitLookahead:
+            return "BestFitLookahead";
+        default:
+            IT_TODO_HALT();
+        }
+    }
+
+    string MemoryPlan::toString() const
+    {
+        std::ostringstream oss;
+        oss << "Memory plan: " << infini::toString(strategy) << ", "
+            << intervals.size() << " buffers, peak " << peak
+            << " bytes, lower bound " << lowerBound << " bytes, gap "
+            << gap() * 100 << "%";
+        return oss.str();
+    }
+
+    MemoryPlanReport makeReport(const MemoryPlan &plan, int numSteps)
+    {
+        MemoryPlanReport report;
+        report.strategy = plan.strategy;
+        report.arenaSize = plan.peak;
+        report.ops.resize(numSteps);
+        vector<long long> delta(numSteps + 1, 0);
+        for (size_t i = 0; i < plan.intervals.size(); ++i)
+        {
+            const auto &interval = plan.intervals[i];
+            const auto &t = interval.tensor;
+            IT_ASSERT(interval.end < numSteps || numSteps == 0);
+            report.tensors.push_back({t->getGuid(), t->getFuid(),
+                                      t->getDType(), t->getDims(),
+                                      plan.offsets[i], interval.bytes,
+                                      interval.begin, interval.end});
+            if (numSteps > 0)
+            {
+                delta[interval.begin] += interval.bytes;
+                delta[interval.end + 1] -= interval.bytes;
+            }
+        }
+        long long live = 0;
+        for (int step = 0; step < numSteps; ++step)
+        {
+            live += delta[step];
+            report.liveBytes.emplace_back(live);
+            if (report.peakStep < 0 || size_t(live) > report.getPeakLiveBytes())
+                report.peakStep = step;
+        }
+        return report;
+    }
+
+    string MemoryPlanReport::toJson() const
+    {
+        std::ostringstream oss;
+        oss << "{\"strategy\":\"" << infini::toString(strategy) << "\""
+            << ",\"arena_size\":" << arenaSize
+            << ",\"peak_step\":" << peakStep
+            << ",\"peak_live_bytes\":" << getPeakLiveBytes()
+            << ",\"fragmentation\":" << getFragmentation() << ",\"steps\":[";
+        for (size_t i = 0; i < liveBytes.size(); ++i)
+            oss << (i ? "," : "") << "{\"op\":\"" << ops[i]
+                << "\",\"live_bytes\":" << liveBytes[i] << "}";
+        oss << "],\"tensors\":[";
+        for (size_t i = 0; i < tensors.size(); ++i)
+        {
+            const auto &t = tensors[i];
+            oss << (i ? "," : "") << "{\"guid\":" << t.guid
+                << ",\"fuid\":" << t.fuid << ",\"dtype\":\""
+                << t.dtype.toString() << "\",\"dims\":" << vecToString(t.dims)
+                << ",\"offset\":" << t.offset << ",\"bytes\":" << t.bytes
+                << ",\"first_op\":" << t.firstOp
+                << ",\"last_op\":" << t.lastOp << "}";
+        }
+        oss << "]}";
+        return oss.str();
+    }
+
+    string MemoryPlanReport::toCsv() const
+    {
+        std::ostringstream oss;
+        oss << "guid,fuid,dtype,dims,offset,bytes,first_op,last_op\n";
+        for (const auto &t : tensors)
+        {
+            oss << t.guid << "," << t.fuid << "," << t.dtype.toString() << ",";
+            for (size_t i = 0; i < t.dims.size(); ++i)
+                oss << (i ? "x" : "") << t.dims[i];
+            oss << "," << t.offset << "," << t.bytes << "," << t.firstOp << ","
+                << t.lastOp << "\n";
+        }
+        return oss.str();
+    }
+
+    MemoryPlanner::MemoryPlanner(size_t alignment, int lookahead)
+        : alignment(alignment), lookahead(lookahead)
+    {
+        IT_ASSERT(alignment > 0);
+        IT_ASSERT(lookahead > 0);
+    }
+
+    void MemoryPlanner::addInterval(const Tensor &tensor, size_t bytes,
+                                    int begin, int end)
+    {
+        IT_ASSERT(begin <= end);
+        intervals.push_back({tensor, getAlignedSize(bytes), begin, end});
+    }
+
+    size_t MemoryPlanner::getAlignedSize(size_t size) const
+    {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    size_t MemoryPlanner::lowerBound() const
+    {
+        if (intervals.empty())
+            return 0;
+        int first = intervals[0].begin, last = intervals[0].end;
+        for (const auto &interval : intervals)
+        {
+            first = std::min(first, interval.begin);
+            last = std::max(last, interval.end);
+        }
+        // Difference array of live bytes over steps.
+        vector<long long> delta(last - first + 2, 0);
+        for (const auto &interval : intervals)
+        {
+            delta[interval.begin - first] += interval.bytes;
+            delta[interval.end - first + 1] -= interval.bytes;
+        }
+        long long live = 0, maxLive = 0;
+        for (auto d : delta)
+        {
+            live += d;
+            maxLive = std::max(maxLive, live);
+        }
+        return maxLive;
+    }
+
+    vector<size_t> MemoryPlanner::placeInOrder(const vector<size_t> &order) const
+    {
+        vector<size_t> offsets(intervals.size(), 0);
+        if (intervals.empty())
+            return offsets;
+        auto placed = makeStepIndex(intervals);
+
+        vector<pair<size_t, size_t>> busy;
+        auto addBusy = [&](size_t other)
+        {
+            busy.emplace_back(offsets[other],
+                              offsets[other] + intervals[other].bytes);
+        };
+        for (auto idx : order)
+        {
+            const auto &cur = intervals[idx];
+            if (cur.bytes == 0)
+                continue;
+            busy.clear();
+            placed.forEachOverlap(cur, addBusy);
+            std::sort(busy.begin(), busy.end());
+
+            // Best fit among the gaps, otherwise on top of everything.
+            size_t cursor = 0, best = 0, bestGap = 0;
+            bool found = false;
+            for (const auto &[start, stop] : busy)
+            {
+                if (start > cursor)
+                {
+                    size_t gap = start - cursor;
+                    if (gap >= cur.bytes && (!found || gap < bestGap))
+                    {
+                        best = cursor;
+                        bestGap = gap;
+                        found = true;
+                    }
+                }
+                cursor = std::max(cursor, stop);
+            }
+            offsets[idx] = found ? best : cursor;
+            placed.insert(idx, cur);
+        }
+        return offsets;
+    }
+
+    vector<size_t> MemoryPlanner::replayOnline() const
+    {
+        const size_t n = intervals.size();
+        vector<size_t> byBegin(n), byEnd(n);
+        std::iota(byBegin.begin(), byBegin.end(), 0);
+        std::iota(byEnd.begin(), byEnd.end(), 0);
+        std::stable_sort(byBegin.begin(), byBegin.end(), [&](auto a, auto b)
+                         { return intervals[a].begin < intervals[b].begin; });
+        std::stable_sort(byEnd.begin(), byEnd.end(), [&](auto a, auto b)
+                         { return intervals[a].end < intervals[b].end; });
+
+        // Allocations of a step happen before the frees of that step.
+        Allocator allocator(nullptr, alignment);
+        vector<size_t> offsets(n, 0);
+        size_t nextAlloc = 0, nextFree = 0;
+        while (nextAlloc < n || nextFree < n)
+        {
+            if (nextAlloc < n &&
+                (nextFree == n || intervals[byBegin[nextAlloc]].begin <=
+                                      intervals[byEnd[nextFree]].end))
+            {
+                auto idx = byBegin[nextAlloc++];
+                if (intervals[idx].bytes > 0)
+                    offsets[idx] = allocator.alloc(intervals[idx].bytes);
+            }
+            else
+            {
+                auto idx = byEnd[nextFree++];
+                if (intervals[idx].bytes > 0)
+                    allocator.free(offsets[idx], intervals[idx].bytes);
+            }
+        }
+        return offsets;
+    }
+
+    MemoryPlan MemoryPlanner::solve(PlanStrategy strategy) const
+    {
+        const size_t n = intervals.size();
+        vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+
+        MemoryPlan plan;
+        plan.strategy = strategy;
+        plan.intervals = intervals;
+        plan.lowerBound = lowerBound();
+
+        switch (strategy)
+        {
+        case PlanStrategy::OnlineBestFit:
+            plan.offsets = replayOnline();
+            break;
+        case PlanStrategy::GreedyBySize:
+            std::stable_sort(order.begin(), order.end(), [&](auto a, auto b)
+                             {
+                                 const auto &x = intervals[a], &y = intervals[b];
+                                 if (x.bytes != y.bytes)
+                                     return x.bytes > y.bytes;
+                                 return x.begin < y.begin; });
+            plan.offsets = placeInOrder(order);
+            break;
+        case PlanStrategy::GreedyByBreadth:
+        {
+            // Breadth of a buffer: the largest live bytes among its steps.
+            int first = 0, last = -1;
+            for (size_t i = 0; i < n; ++i)
+            {
+                first = i ? std::min(first, intervals[i].begin)
+                          : intervals[i].begin;
+                last = std::max(last, intervals[i].end);
+            }
+            const size_t steps = std::max(last - first + 1, 0);
+            vector<long long> live(steps + 1, 0);
+            for (const auto &interval : intervals)
+            {
+                live[interval.begin - first] += interval.bytes;
+                live[interval.end - first + 1] -= interval.bytes;
+            }
+            for (size_t s = 1; s < steps; ++s)
+                live[s] += live[s - 1];
+            // Sparse table of range maxima over the live bytes.
+            vector<vector<long long>> maxima{live};
+            for (size_t width = 1; 2 * width <= steps; width *= 2)
+            {
+                const auto &prev = maxima.back();
+                vector<long long> next(steps - 2 * width + 1);
+                for (size_t s = 0; s < next.size(); ++s)
+                    next[s] = std::max(prev[s], prev[s + width]);
+                maxima.emplace_back(std::move(next));
+            }
+            vector<size_t> breadth(n, 0);
+            for (size_t i = 0; i < n; ++i)
+            {
+                size_t lo = intervals[i].begin - first,
+                       hi = intervals[i].end - first + 1;
+                size_t level = 0;
+                while (size_t(2) << level <= hi - lo)
+                    ++level;
+                breadth[i] = std::max(maxima[level][lo],
+                                      maxima[level][hi - (size_t(1) << level)]);
+            }
+            std::stable_sort(order.begin(), order.end(), [&](auto a, auto b)
+                             {
+                                 if (breadth[a] != breadth[b])
+                                     return breadth[a] > breadth[b];
+                                 return intervals[a].bytes > intervals[b].bytes; });
+            plan.offsets = placeInOrder(order);
+            break;
+        }
+        case PlanStrategy::BestFitLookahead:
+            std::stable_sort(order.begin(), order.end(), [&](auto a, auto b)
+                             {
+                                 const auto &x = intervals[a], &y = intervals[b];
+                                 int wx = x.begin / lookahead, wy = y.begin / lookahead;
+                                 if (wx != wy)
+                                     return wx < wy;
+                                 return x.bytes > y.bytes; });
+            plan.offsets = placeInOrder(order);
+            break;
+        default:
+            IT_TODO_HALT();
+        }
+
+        for (size_t i = 0; i < n; ++i)
+            plan.peak = std::max(plan.peak, plan.offsets[i] + intervals[i].bytes);
+        return plan;
+    }
+
+    MemoryPlan MemoryPlanner::solve(const vector<PlanStrategy> &strategies) const
+    {
+        IT_ASSERT(!strategies.empty());
+        MemoryPlan best;
+        for (size_t i = 0; i < strategies.size(); ++i)
+        {
+            auto plan = solve(strategies[i]);
+            if (i == 0 || plan.peak < best.peak)
+                best = std::move(plan);
+            if (best.peak == best.lowerBound)
+                break;
+        }
+        return best;
+    }
+
+    const vector<PlanStrategy> &MemoryPlanner::allStrategies()
+    {
+        static const vector<PlanStrategy> strategies{
+            PlanStrategy::OnlineBestFit, PlanStrategy::GreedyBySize,
+            PlanStrategy::GreedyByBreadth, PlanStrategy::BestFitLookahead};
+        return strategies;
+    }
+
+    SymbolicPlan::SymbolicPlan(const MemoryPlan &reference,
+                               vector<SymExpr> sizes, size_t alignment)
+        : alignment(alignment), strategy(reference.strategy),
+          intervals(reference.intervals), sizes(std::move(sizes)),
+          order(intervals.size()), below(intervals.size())
+    {
+        IT_ASSERT(this->sizes.size() == intervals.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](auto a, auto b)
+                         { return reference.offsets[a] < reference.offsets[b]; });
+        if (intervals.empty())
+            return;
+        auto placed = makeStepIndex(intervals);
+        for (auto idx : order)
+        {
+            placed.forEachOverlap(intervals[idx], [&](size_t other)
+                                  { below[idx].emplace_back(other); });
+            placed.insert(idx, intervals[idx]);
+        }
+    }
+
+    MemoryPlan SymbolicPlan::evaluate(const SymBindings &bindings) const
+    {
+        MemoryPlanner planner(alignment);
+        for (size_t i = 0; i < intervals.size(); ++i)
+        {
+            auto bytes = sizes[i].evaluate(bindings);
+            IT_ASSERT(bytes >= 0);
+            const auto &interval = intervals[i];
+            planner.addInterval(interval.tensor, bytes, interval.begin,
+                                interval.end);
+        }
+
+        MemoryPlan plan;
+        plan.strategy = strategy;
+        plan.intervals = planner.getIntervals();
+        plan.lowerBound = planner.lowerBound();
+        plan.offsets.assign(intervals.size(), 0);
+        for (auto idx : order)
+        {
+            size_t offset = 0;
+            for (auto other : below[idx])
+                offset = std::max(offset, plan.offsets[other] +
+                                              plan.intervals[other].bytes);
+            plan.offsets[idx] = offset;
+            plan.peak = std::max(plan.peak, offset + plan.intervals[idx].bytes);
+        }
+        return plan;
+    }
+
+} // namespace infini
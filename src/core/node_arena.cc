@@ -0,0 +1,40 @@
+#include "core/node_arena.h"
+#include "core/caching_allocator.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace infini
+{
+    NodeArenaObj::~NodeArenaObj()
+    {
+        auto &allocator = CachingAllocator::getInstance();
+        for (void *chunk : chunks)
+            allocator.dealloc(chunk);
+    }
+
+    void *NodeArenaObj::allocate(size_t bytes, size_t alignment)
+    {
+        auto aligned = [&]
+        {
+            auto address = reinterpret_cast<uintptr_t>(cursor);
+            return reinterpret_cast<char *>((address + alignment - 1) /
+                                            alignment * alignment);
+        };
+        if (cursor == nullptr || aligned() + bytes > limit)
+        {
+            // Chunks are cached across graphs, so building graph after graph
+            // does not map and fault in fresh pages. Oversized requests get
+            // a chunk of their own.
+            size_t size = std::max(chunkSize, bytes + alignment);
+            cursor = static_cast<char *>(
+                CachingAllocator::getInstance().alloc(size, ArenaOptions{}));
+            limit = cursor + size;
+            chunks.emplace_back(cursor);
+        }
+        char *ptr = aligned();
+        allocatedBytes += ptr + bytes - cursor;
+        cursor = ptr + bytes;
+        return ptr;
+    }
+
+} // namespace infini
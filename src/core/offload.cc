@@ -0,0 +1,138 @@
+#include "core/offload.h"
+#include "core/blob.h"
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace infini
+{
+    OffloaderObj::OffloaderObj(Runtime runtime, const OffloadOptions &options,
+                               vector<pair<Tensor, vector<Segment>>> tensors)
+        : file(nullptr), fileSize(0)
+    {
+        const size_t pageSize = sysconf(_SC_PAGESIZE);
+        for (auto &[tensor, segments] : tensors)
+        {
+            IT_ASSERT(segments.size() > 1);
+            Entry entry{tensor, std::move(segments), {}, fileSize, false};
+            for (const auto &segment : entry.segments)
+                entry.blobs.emplace_back(make_ref<BlobObj>(runtime, segment.ptr));
+            size_t index = entries.size();
+            for (size_t i = 0; i < entry.segments.size(); ++i)
+            {
+                const auto &segment = entry.segments[i];
+                if (i + 1 < entry.segments.size())
+                    evictions[segment.end].emplace_back(index, i);
+                if (i > 0)
+                {
+                    IT_ASSERT(segment.begin < segment.firstUse);
+                    prefetches[segment.begin].emplace_back(index, i);
+                    waits[segment.firstUse].emplace_back(index, i);
+                }
+            }
+            fileSize += (tensor->getBytes() + pageSize - 1) / pageSize * pageSize;
+            entries.emplace_back(std::move(entry));
+        }
+        if (fileSize == 0)
+            return;
+
+        // The file is unlinked right away and lives as long as the mapping.
+        string path = options.directory + "/infini-offload-XXXXXX";
+        int fd = mkstemp(path.data());
+        IT_ASSERT(fd >= 0, "Cannot create a scratch file in " + options.directory);
+        unlink(path.c_str());
+        bool resized = ftruncate(fd, fileSize) == 0;
+        if (resized)
+            file = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fd, 0);
+        ::close(fd);
+        IT_ASSERT(resized && file != MAP_FAILED,
+                  "Cannot map a scratch file of " + std::to_string(fileSize) +
+                      " bytes");
+    }
+
+    OffloaderObj::~OffloaderObj()
+    {
+        for (auto &[index, future] : pending)
+            future.wait();
+        if (file != nullptr)
+            munmap(file, fileSize);
+    }
+
+    void OffloaderObj::beforeStep(int step)
+    {
+        if (step == 0)
+        {
+            // Each run starts from the first segments, where the inputs are
+            // set and the producers write.
+            for (auto &entry : entries)
+            {
+                entry.tensor->setDataBlob(entry.blobs[0]);
+                entry.written = false;
+            }
+        }
+        if (auto it = prefetches.find(step); it != prefetches.end())
+            for (auto [index, i] : it->second)
+            {
+                const auto &entry = entries[index];
+                void *dst = entry.segments[i].ptr;
+                const void *src = static_cast<char *>(file) + entry.fileOffset;
+                size_t bytes = entry.tensor->getBytes();
+                pending[index] = std::async(std::launch::async, [=]
+                                            { std::memcpy(dst, src, bytes); });
+            }
+        if (auto it = waits.find(step); it != waits.end())
+            for (auto [index, i] : it->second)
+            {
+                pending.at(index).wait();
+                pending.erase(index);
+                entries[index].tensor->setDataBlob(entries[index].blobs[i]);
+            }
+    }
+
+    void OffloaderObj::afterStep(int step)
+    {
+        auto it = evictions.find(step);
+        if (it == evictions.end())
+            return;
+        for (auto [index, i] : it->second)
+        {
+            // The data does not change after it is produced, so later spans
+            // reuse the first copy. The slot is handed to other tensors from
+            // the next step on, so the copy completes here.
+            auto &entry = entries[index];
+            if (entry.written)
+                continue;
+            size_t bytes = entry.tensor->getBytes();
+            char *dst = static_cast<char *>(file) + entry.fileOffset;
+            std::memcpy(dst, entry.segments[i].ptr, bytes);
+            // Start writeback so that the pages can be reclaimed early.
+            msync(dst, bytes, MS_ASYNC);
+            entry.written = true;
+        }
+    }
+
+    vector<pair<int, int>> OffloaderObj::split(const OffloadOptions &options,
+                                               int begin, int end,
+                                               const vector<int> &uses)
+    {
+        vector<pair<int, int>> segments;
+        int start = begin, last = begin;
+        for (int use : uses)
+        {
+            int idle = use - last - 1;
+            if (idle >= options.minIdleSteps)
+            {
+                int distance = options.prefetchSteps > 0
+                                   ? options.prefetchSteps
+                                   : std::max(1, idle / 4);
+                segments.emplace_back(start, last);
+                start = use - std::min(distance, idle);
+            }
+            last = std::max(last, use);
+        }
+        segments.emplace_back(start, end);
+        return segments;
+    }
+
+} // namespace infini
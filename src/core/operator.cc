@@ -7,26 +7,39 @@ namespace infini
     OperatorObj::OperatorObj(OpType opType, TensorVec inputs, TensorVec outputs)
         : type(opType), inputs(inputs), outputs(outputs) {}
 
-    void OperatorObj::removePredecessors(const Operator &op)
+    OpCost OperatorObj::getCost() const
     {
-        for (auto it = predecessors.begin(); it != predecessors.end();)
+        OpCost cost;
+        for (const auto &input : inputs)
+            cost.bytesRead += input->getBytes();
+        for (const auto &output : outputs)
         {
-            if (it->lock() == op)
-                it = predecessors.erase(it);
-            else
-                ++it;
+            cost.flops += output->size();
+            cost.bytesWritten += output->getBytes();
         }
+        return cost;
     }
 
-    void OperatorObj::removeSuccessors(const Operator &op)
+    string OpCost::toString() const
     {
-        for (auto it = successors.begin(); it != successors.end();)
-        {
-            if (it->lock() == op)
-                it = successors.erase(it);
-            else
-                ++it;
-        }
+        std::ostringstream oss;
+        oss << "OpCost(flops=" << flops << ", bytesRead=" << bytesRead
+            << ", bytesWritten=" << bytesWritten
+            << ", intensity=" << getArithmeticIntensity() << ")";
+        return oss.str();
+    }
+
+    void OperatorObj::removePredecessors(const OperatorObj *op)
+    {
+        predecessors.erase(
+            std::remove(predecessors.begin(), predecessors.end(), op),
+            predecessors.end());
+    }
+
+    void OperatorObj::removeSuccessors(const OperatorObj *op)
+    {
+        successors.erase(std::remove(successors.begin(), successors.end(), op),
+                         successors.end());
     }
 
     void OperatorObj::replaceInput(Tensor t1, Tensor t2)
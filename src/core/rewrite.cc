@@ -0,0 +1,274 @@
+#include "core/rewrite.h"
+
+namespace infini
+{
+    bool Pattern::match(const Operator &op, OpVec &matched) const
+    {
+        if (!op || op->getOpType() != type || (predicate && !predicate(op)))
+            return false;
+        size_t mark = matched.size();
+        matched.emplace_back(op);
+        for (const auto &[index, pattern] : inputs)
+        {
+            Operator source;
+            if (index < int(op->getInputs().size()) && op->getInputs(index))
+                source = op->getInputs(index)->getSource();
+            if (!source || !pattern.match(source, matched))
+            {
+                matched.resize(mark);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    GraphRewriter::GraphRewriter(GraphObj &graph)
+        : graph(graph), orderValid(graph.sorted), changed(false)
+    {
+        positions.reserve(graph.ops.size());
+        for (size_t i = 0; i < graph.ops.size(); ++i)
+        {
+            positions.emplace(graph.ops[i].get(), i);
+            enqueue(graph.ops[i]);
+        }
+    }
+
+    bool GraphRewriter::run()
+    {
+        const auto &registry = RewriteRuleRegistry::getInstance();
+        OpVec matched;
+        while (!worklist.empty())
+        {
+            auto op = std::move(worklist.front());
+            worklist.pop_front();
+            queued.erase(op.get());
+            for (const auto &record : registry.getRules(op->getOpType()))
+            {
+                if (isErased(op))
+                    break;
+                matched.clear();
+                if (record.pattern.match(op, matched))
+                    record.rule->rewrite(*this, matched);
+            }
+        }
+        return commit();
+    }
+
+    bool GraphRewriter::commit()
+    {
+        if (!changed)
+            return false;
+        compact();
+        graph.invalidatePlans();
+        graph.inferredInputShapes.clear();
+        if (!orderValid)
+        {
+            graph.sorted = false;
+            IT_ASSERT(graph.topo_sort() == true);
+            orderValid = true;
+        }
+        positions.clear();
+        for (size_t i = 0; i < graph.ops.size(); ++i)
+            positions.emplace(graph.ops[i].get(), i);
+        changed = false;
+        return true;
+    }
+
+    void GraphRewriter::enqueue(const Operator &op)
+    {
+        if (op && !isErased(op) && queued.insert(op.get()).second)
+            worklist.emplace_back(op);
+    }
+
+    void GraphRewriter::enqueue(OperatorObj *op)
+    {
+        // A reference is only taken for ops not queued yet.
+        if (!erased.count(op) && queued.insert(op).second)
+            worklist.emplace_back(op->shared_from_this());
+    }
+
+    void GraphRewriter::enqueueNeighbors(const Operator &op)
+    {
+        enqueue(op);
+        for (auto *pred : op->getPredecessorView())
+            enqueue(pred);
+        for (auto *succ : op->getSuccessorView())
+            enqueue(succ);
+    }
+
+    void GraphRewriter::replaceAllUses(const Tensor &from, const Tensor &to)
+    {
+        // Each consumer once, even if it uses `from` several times.
+        OpVec consumers;
+        for (auto *op : from->getTargetView())
+            if (std::find_if(consumers.begin(), consumers.end(),
+                             [&](const Operator &c) { return c.get() == op; }) ==
+                consumers.end())
+                consumers.emplace_back(op->shared_from_this());
+        for (const auto &op : consumers)
+            replaceUse(op, from, to);
+    }
+
+    void GraphRewriter::replaceUse(const Operator &op, const Tensor &from,
+                                   const Tensor &to)
+    {
+        IT_ASSERT(from != to);
+        size_t uses = std::count(op->inputs.begin(), op->inputs.end(), from);
+        IT_ASSERT(uses > 0, "Op does not consume the tensor");
+        changed = true;
+        op->replaceInput(from, to);
+        from->removeTarget(op);
+        for (size_t i = 0; i < uses; ++i)
+            to->addTarget(op);
+        detached.insert(from.get());
+
+        if (auto source = from->getSource())
+        {
+            bool stillConsumed = false;
+            for (const auto &input : op->inputs)
+                if (input && input->getSource() == source)
+                    stillConsumed = true;
+            if (!stillConsumed)
+            {
+                source->removeSuccessors(op);
+                op->removePredecessors(source);
+            }
+            enqueue(source);
+        }
+        if (auto source = to->getSource())
+        {
+            auto preds = op->getPredecessorView();
+            if (std::find(preds.begin(), preds.end(), source.get()) == preds.end())
+            {
+                source->addSuccessors(op);
+                op->addPredecessors(source);
+            }
+            if (!precedes(source.get(), op.get()))
+                orderValid = false;
+            enqueue(source);
+        }
+        enqueue(op);
+    }
+
+    void GraphRewriter::eraseOperator(const Operator &op)
+    {
+        if (isErased(op))
+            return;
+        for (const auto &output : op->outputs)
+            IT_ASSERT(!output || output->targets.empty() ||
+                          output->source.lock() != op,
+                      "Erasing an op whose outputs are still consumed");
+        changed = true;
+        enqueueNeighbors(op);
+        for (const auto &input : op->inputs)
+            if (input)
+            {
+                input->removeTarget(op);
+                detached.insert(input.get());
+            }
+        for (const auto &output : op->outputs)
+            if (output)
+            {
+                if (output->source.lock() == op)
+                    output->source.reset();
+                detached.insert(output.get());
+            }
+        for (auto *pred : op->getPredecessorView())
+            pred->removeSuccessors(op);
+        for (auto *succ : op->getSuccessorView())
+            succ->removePredecessors(op);
+        op->predecessors.clear();
+        op->successors.clear();
+        erased.insert(op.get());
+    }
+
+    void GraphRewriter::moveOutput(const Tensor &from, const Tensor &to)
+    {
+        auto source = from->getSource();
+        IT_ASSERT(source && !to->getSource());
+        replaceAllUses(from, to);
+        std::replace(source->outputs.begin(), source->outputs.end(), from, to);
+        from->source.reset();
+        to->setSource(source);
+        detached.insert(from.get());
+        for (auto *op : to->getTargetView())
+        {
+            auto preds = op->getPredecessorView();
+            if (std::find(preds.begin(), preds.end(), source.get()) == preds.end())
+            {
+                source->addSuccessors(op);
+                op->addPredecessors(source);
+            }
+            if (!precedes(source.get(), op))
+                orderValid = false;
+        }
+        changed = true;
+        enqueueNeighbors(source);
+    }
+
+    void GraphRewriter::insertOperator(const Operator &op,
+                                       const Operator &before)
+    {
+        IT_ASSERT(!isErased(before));
+        auto &list = inserted[before.get()];
+        positions.emplace(op.get(), positions.at(before.get()));
+        insertedAt.emplace(op.get(), std::make_pair(before.get(), list.size()));
+        list.emplace_back(op);
+        graph.connect(op);
+        for (auto *pred : op->getPredecessorView())
+            if (!precedes(pred, op.get()))
+                orderValid = false;
+        for (auto *succ : op->getSuccessorView())
+            if (!precedes(op.get(), succ))
+                orderValid = false;
+        changed = true;
+        enqueueNeighbors(op);
+    }
+
+    bool GraphRewriter::precedes(const OperatorObj *a,
+                                 const OperatorObj *b) const
+    {
+        size_t pa = positions.at(a), pb = positions.at(b);
+        if (pa != pb)
+            return pa < pb;
+        auto ia = insertedAt.find(a), ib = insertedAt.find(b);
+        if (ia == insertedAt.end())
+            return false;
+        // Ops inserted before an op at some depth are emitted before it.
+        if (ib == insertedAt.end())
+            return true;
+        return ia->second.first == ib->second.first &&
+               ia->second.second < ib->second.second;
+    }
+
+    void GraphRewriter::compact()
+    {
+        OpVec ops;
+        ops.reserve(graph.ops.size());
+        std::function<void(const Operator &)> emit = [&](const Operator &op)
+        {
+            if (auto it = inserted.find(op.get()); it != inserted.end())
+                for (const auto &prior : it->second)
+                    emit(prior);
+            if (!erased.count(op.get()))
+                ops.emplace_back(op);
+        };
+        for (const auto &op : graph.ops)
+            emit(op);
+        graph.ops = std::move(ops);
+        inserted.clear();
+        insertedAt.clear();
+        auto &tensors = graph.tensors;
+        tensors.erase(std::remove_if(tensors.begin(), tensors.end(),
+                                     [&](const Tensor &t)
+                                     {
+                                         return detached.count(t.get()) &&
+                                                !t->getSource() &&
+                                                t->targets.empty();
+                                     }),
+                      tensors.end());
+        erased.clear();
+        detached.clear();
+    }
+
+} // namespace infini
@@ -1,22 +1,104 @@
 #include "core/runtime.h"
 #include "core/blob.h"
+#include "core/execution_context.h"
 #include "core/kernel.h"
 #include "core/graph.h"
 #include "core/kernel.h"
 #include <chrono>
 #include <cstring>
+#include <exception>
 #include <memory>
+#include <optional>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 namespace infini
 {
+#ifdef _OPENMP
+    namespace
+    {
+        // Restores the caller's OpenMP thread count on every exit.
+        struct ThreadCountGuard
+        {
+            const int threads = omp_get_max_threads();
+            ~ThreadCountGuard() { omp_set_num_threads(threads); }
+        };
+    } // namespace
+#endif
+
     void NativeCpuRuntimeObj::run(const Graph &graph) const
     {
         const auto &kernelRegistry = KernelRegistry::getInstance();
+#ifdef _OPENMP
+        const ThreadCountGuard userThreads;
+#endif
 
-        for (auto &op : graph->getOperators())
+        const auto &ops = graph->getOperators();
+        auto getKernel = [&](const Operator &op)
         {
             auto kernelAttrs = KernelAttrs{device, op->getOpType().underlying()};
-            Kernel *kernel = kernelRegistry.getKernel(kernelAttrs);
-            kernel->compute(op, this);
+            return kernelRegistry.getKernel(kernelAttrs);
+        };
+        // Without a schedule from dataMalloc, ops run one by one.
+        auto stages = graph->getStages();
+        if (stages.empty() || stages.back() != ops.size())
+        {
+            stages.clear();
+            for (size_t i = 0; i <= ops.size(); ++i)
+                stages.emplace_back(i);
+        }
+
+        const auto &offloader = graph->getOffloader();
+        for (size_t stage = 0; stage + 1 < stages.size(); ++stage)
+        {
+            const size_t begin = stages[stage], end = stages[stage + 1];
+            if (offloader)
+                offloader->beforeStep(stage);
+            if (end - begin == 1)
+            {
+                Kernel *kernel = getKernel(ops[begin]);
+#ifdef _OPENMP
+                omp_set_num_threads(
+                    machineModel.threadsFor(ops[begin]->getCost()));
+#endif
+                kernel->compute(ops[begin], this);
+                if (offloader)
+                    offloader->afterStep(stage);
+                continue;
+            }
+            // Independent ops of a stage run concurrently, one thread each;
+            // the memory plan keeps their buffers disjoint. Worker threads
+            // resolve data through the caller's execution context.
+            const auto *context = ExecutionContextObj::current();
+            // Exceptions cannot leave a parallel region; the first one is
+            // rethrown after it.
+            std::exception_ptr error;
+#ifdef _OPENMP
+            omp_set_num_threads(userThreads.threads);
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+            for (size_t i = begin; i < end; ++i)
+            {
+                try
+                {
+                    std::optional<ExecutionContextObj::ActiveScope> scope;
+                    if (context)
+                        scope.emplace(*context);
+                    getKernel(ops[i])->compute(ops[i], this);
+                }
+                catch (...)
+                {
+#ifdef _OPENMP
+#pragma omp critical(infini_stage_error)
+#endif
+                    if (!error)
+                        error = std::current_exception();
+                }
+            }
+            if (error)
+                std::rethrow_exception(error);
+            if (offloader)
+                offloader->afterStep(stage);
         }
     }
 
@@ -24,13 +106,19 @@ namespace infini
 
     void NativeCpuRuntimeObj::dealloc(void *ptr)
     {
-        return free(ptr);
+        CachingAllocator::getInstance().dealloc(ptr);
     }
 
     void *NativeCpuRuntimeObj::alloc(size_t size)
     {
-        return calloc((size + sizeof(uint64_t) - 1) / sizeof(uint64_t),
-                      sizeof(uint64_t));
+        return CachingAllocator::getInstance().alloc(size, arenaOptions);
+    }
+
+    void *NativeCpuRuntimeObj::allocZeroed(size_t size)
+    {
+        auto options = arenaOptions;
+        options.zero = true;
+        return CachingAllocator::getInstance().alloc(size, options);
     }
 
 } // namespace infini
@@ -0,0 +1,133 @@
+#include "core/symbolic.h"
+#include <limits>
+
+namespace infini
+{
+    SymExpr::SymExpr(int64_t constant)
+    {
+        if (constant != 0)
+            terms.emplace(vector<string>{}, constant);
+    }
+
+    SymExpr SymExpr::var(const string &name)
+    {
+        IT_ASSERT(!name.empty());
+        SymExpr expr;
+        expr.terms.emplace(vector<string>{name}, 1);
+        return expr;
+    }
+
+    SymExpr SymExpr::operator+(const SymExpr &rhs) const
+    {
+        SymExpr sum = *this;
+        for (const auto &[monomial, coef] : rhs.terms)
+            if ((sum.terms[monomial] += coef) == 0)
+                sum.terms.erase(monomial);
+        return sum;
+    }
+
+    SymExpr SymExpr::operator-(const SymExpr &rhs) const
+    {
+        return *this + rhs * SymExpr(-1);
+    }
+
+    SymExpr SymExpr::operator*(const SymExpr &rhs) const
+    {
+        SymExpr product;
+        for (const auto &[lhsMonomial, lhsCoef] : terms)
+            for (const auto &[rhsMonomial, rhsCoef] : rhs.terms)
+            {
+                vector<string> monomial;
+                std::merge(lhsMonomial.begin(), lhsMonomial.end(),
+                           rhsMonomial.begin(), rhsMonomial.end(),
+                           std::back_inserter(monomial));
+                if ((product.terms[monomial] += lhsCoef * rhsCoef) == 0)
+                    product.terms.erase(monomial);
+            }
+        return product;
+    }
+
+    optional<int64_t> SymExpr::getConstant() const
+    {
+        if (terms.empty())
+            return 0;
+        if (terms.size() == 1 && terms.begin()->first.empty())
+            return terms.begin()->second;
+        return std::nullopt;
+    }
+
+    int64_t SymExpr::evaluate(const SymBindings &bindings) const
+    {
+        int64_t value = 0;
+        for (const auto &[monomial, coef] : terms)
+        {
+            int64_t term = coef;
+            for (const auto &name : monomial)
+            {
+                auto it = bindings.find(name);
+                IT_ASSERT(it != bindings.end(), "Unbound dimension " + name);
+                term *= it->second;
+            }
+            value += term;
+        }
+        return value;
+    }
+
+    string SymExpr::toString() const
+    {
+        if (terms.empty())
+            return "0";
+        std::ostringstream os;
+        bool first = true;
+        // Highest degree first.
+        for (auto it = terms.rbegin(); it != terms.rend(); ++it)
+        {
+            auto [monomial, coef] = *it;
+            os << (coef < 0 ? (first ? "-" : " - ") : (first ? "" : " + "));
+            coef = std::abs(coef);
+            if (coef != 1 || monomial.empty())
+                os << coef << (monomial.empty() ? "" : "*");
+            for (size_t i = 0; i < monomial.size(); ++i)
+                os << (i > 0 ? "*" : "") << monomial[i];
+            first = false;
+        }
+        return os.str();
+    }
+
+    SymShape toSymShape(const vector<int> &dims)
+    {
+        return SymShape(dims.begin(), dims.end());
+    }
+
+    vector<int> evaluate(const SymShape &shape, const SymBindings &bindings)
+    {
+        vector<int> dims;
+        dims.reserve(shape.size());
+        for (const auto &dim : shape)
+        {
+            auto value = dim.evaluate(bindings);
+            IT_ASSERT(value >= 0 && value <= std::numeric_limits<int>::max(),
+                      "Dimension " + dim.toString() + " evaluates to " +
+                          std::to_string(value));
+            dims.emplace_back(value);
+        }
+        return dims;
+    }
+
+    SymExpr getNumElements(const SymShape &shape)
+    {
+        SymExpr count(1);
+        for (const auto &dim : shape)
+            count = count * dim;
+        return count;
+    }
+
+    string toString(const SymShape &shape)
+    {
+        string ret = "[";
+        for (size_t i = 0; i < shape.size(); ++i)
+            ret += (i > 0 ? "," : "") + shape[i].toString();
+        return ret + "]";
+    }
+
+} // namespace infini
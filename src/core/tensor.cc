@@ -1,5 +1,6 @@
 #include "core/tensor.h"
 #include "core/blob.h"
+#include "core/execution_context.h"
 #include "core/operator.h"
 #include "core/runtime.h"
 #include <cstring>
@@ -25,7 +26,7 @@ namespace infini {
                      ", " + ss.str() + "\n";
         vector<UidBaseType> targetGuids;
         for (const auto &op : targets)
-            targetGuids.emplace_back(op.lock()->getGuid());
+            targetGuids.emplace_back(op->getGuid());
         if (auto o = source.lock())
             ret += ", source " + std::to_string(o->getGuid());
         else
@@ -34,6 +35,8 @@ namespace infini {
         return ret;
     }
 
+    OpVec TensorObj::getTargets() const { return ptrs_to_refs(getTargetView()); }
+
 void TensorObj::setShape(Shape shape_) {
     shape = shape_;
     size_t size = std::accumulate(shape.begin(), shape.end(), 1,
@@ -41,6 +44,14 @@ void TensorObj::setShape(Shape shape_) {
     _size = size;
 }
 
+void TensorObj::setSymbolicShape(optional<SymShape> shape_) {
+    IT_ASSERT(!shape_ || shape_->size() == shape.size(),
+              "Symbolic shape " + infini::toString(*shape_) + " has rank " +
+                  std::to_string(shape_->size()) + ", the tensor " +
+                  std::to_string(shape.size()));
+    symbolicShape = std::move(shape_);
+}
+
 void TensorObj::printData() const {
     IT_ASSERT(data != nullptr);
     if (!runtime->isCpu())
@@ -113,4 +124,12 @@ void TensorObj::setData(
 
 void TensorObj::setDataBlob(const Blob &blob) { this->data = blob; }
 
+void *TensorObj::getDataPtr() const {
+    if (auto context = ExecutionContextObj::current())
+        if (auto ptr = context->lookup(this))
+            return ptr;
+    IT_ASSERT(data != nullptr);
+    return data->getPtr<void *>();
+}
+
 }; // namespace infini
@@ -0,0 +1,191 @@
+#include "core/weight_file.h"
+#include "core/blob.h"
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace infini
+{
+    namespace
+    {
+        constexpr char magic[8] = {'I', 'T', 'W', 'E', 'I', 'G', 'H', 'T'};
+        constexpr uint32_t version = 1;
+
+        class Reader
+        {
+            const char *data;
+            size_t length, cursor = 0;
+
+        public:
+            Reader(const void *data, size_t length)
+                : data(static_cast<const char *>(data)), length(length) {}
+
+            void read(void *dst, size_t bytes)
+            {
+                IT_ASSERT(cursor + bytes <= length, "Truncated weight file");
+                std::memcpy(dst, data + cursor, bytes);
+                cursor += bytes;
+            }
+
+            template <typename T>
+            T read()
+            {
+                T value;
+                read(&value, sizeof(T));
+                return value;
+            }
+        };
+
+        template <typename T>
+        void write(std::ofstream &ofs, T value)
+        {
+            ofs.write(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+    } // namespace
+
+    WeightFile WeightFileObj::open(Runtime runtime, const string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        IT_ASSERT(fd >= 0, "Cannot open weight file " + path);
+        struct stat st;
+        IT_ASSERT(fstat(fd, &st) == 0);
+        size_t length = st.st_size;
+        IT_ASSERT(length >= sizeof(magic), "Not a weight file: " + path);
+        void *base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        IT_ASSERT(base != MAP_FAILED, "Cannot map weight file " + path);
+
+        std::unordered_map<string, Entry> entries;
+        try
+        {
+            Reader reader(base, length);
+            char header[sizeof(magic)];
+            reader.read(header, sizeof(header));
+            IT_ASSERT(std::memcmp(header, magic, sizeof(magic)) == 0,
+                      "Not a weight file: " + path);
+            IT_ASSERT(reader.read<uint32_t>() == version,
+                      "Unsupported weight file version");
+            auto count = reader.read<uint32_t>();
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                string name(reader.read<uint32_t>(), '\0');
+                reader.read(name.data(), name.size());
+                auto index = reader.read<int32_t>();
+                IT_ASSERT(index >= 0 &&
+                              size_t(index) < std::size(DataType::sizePerElement) &&
+                              DataType::sizePerElement[index] > 0,
+                          "Unknown dtype in weight entry " + name);
+                DataType dtype(index);
+                Shape dims(reader.read<uint32_t>());
+                uint64_t expected = dtype.getSize();
+                for (auto &d : dims)
+                {
+                    d = reader.read<int32_t>();
+                    IT_ASSERT(d >= 0 && (d == 0 || expected <= UINT64_MAX / d),
+                              "Corrupted shape in weight entry " + name);
+                    expected *= d;
+                }
+                auto offset = reader.read<uint64_t>();
+                auto bytes = reader.read<uint64_t>();
+                IT_ASSERT(bytes == expected,
+                          "Size mismatch in weight entry " + name);
+                IT_ASSERT(offset % dataAlignment == 0 &&
+                              (bytes == 0 ||
+                               (offset <= length && bytes <= length - offset)),
+                          "Corrupted weight entry " + name);
+                entries.emplace(std::move(name), Entry{dtype, dims, offset, bytes});
+            }
+        }
+        catch (...)
+        {
+            munmap(base, length);
+            throw;
+        }
+        return make_ref<WeightFileObj>(runtime, base, length, std::move(entries));
+    }
+
+    void WeightFileObj::save(const string &path,
+                             const vector<pair<string, Tensor>> &weights)
+    {
+        // Header and entry table first, to know where the data begins.
+        size_t tableBytes = sizeof(magic) + 2 * sizeof(uint32_t);
+        for (const auto &[name, t] : weights)
+            tableBytes += sizeof(uint32_t) + name.size() + sizeof(int32_t) +
+                          sizeof(uint32_t) + t->getRank() * sizeof(int32_t) +
+                          2 * sizeof(uint64_t);
+        auto align = [](size_t x)
+        { return (x + dataAlignment - 1) / dataAlignment * dataAlignment; };
+
+        std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+        IT_ASSERT(static_cast<bool>(ofs), "Cannot write weight file " + path);
+        ofs.write(magic, sizeof(magic));
+        write<uint32_t>(ofs, version);
+        write<uint32_t>(ofs, weights.size());
+        vector<size_t> offsets;
+        size_t offset = align(tableBytes);
+        for (const auto &[name, t] : weights)
+        {
+            write<uint32_t>(ofs, name.size());
+            ofs.write(name.data(), name.size());
+            write<int32_t>(ofs, t->getDType().getIndex());
+            write<uint32_t>(ofs, t->getRank());
+            for (auto d : t->getDims())
+                write<int32_t>(ofs, d);
+            write<uint64_t>(ofs, offset);
+            write<uint64_t>(ofs, t->getBytes());
+            offsets.emplace_back(offset);
+            offset = align(offset + t->getBytes());
+        }
+        for (size_t i = 0; i < weights.size(); ++i)
+        {
+            const auto &t = weights[i].second;
+            ofs.seekp(offsets[i]);
+            ofs.write(t->getRawDataPtr<char *>(), t->getBytes());
+        }
+        IT_ASSERT(static_cast<bool>(ofs), "Failed to write weight file " + path);
+    }
+
+    WeightFileObj::WeightFileObj(Runtime runtime, void *base, size_t length,
+                                 std::unordered_map<string, Entry> entries)
+        : runtime(runtime), base(base), length(length),
+          entries(std::move(entries)) {}
+
+    WeightFileObj::~WeightFileObj() { munmap(base, length); }
+
+    bool WeightFileObj::contains(const string &name) const
+    {
+        return entries.count(name) > 0;
+    }
+
+    const WeightFileObj::Entry &WeightFileObj::getEntry(const string &name) const
+    {
+        auto it = entries.find(name);
+        IT_ASSERT(it != entries.end(), "No weight named " + name);
+        return it->second;
+    }
+
+    vector<string> WeightFileObj::getNames() const
+    {
+        vector<string> names;
+        for (const auto &[name, entry] : entries)
+            names.emplace_back(name);
+        return names;
+    }
+
+    void WeightFileObj::bind(const Tensor &tensor, const string &name)
+    {
+        const auto &entry = getEntry(name);
+        IT_ASSERT(entry.dtype == tensor->getDType() &&
+                      entry.dims == tensor->getDims(),
+                  "Weight " + name + " does not match the tensor");
+        auto ptr = static_cast<char *>(base) + entry.offset;
+        tensor->setWeight();
+        tensor->setDataBlob(make_ref<BlobObj>(runtime, ptr, shared_from_this()));
+    }
+
+} // namespace infini
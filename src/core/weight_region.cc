@@ -0,0 +1,42 @@
+#include "core/weight_region.h"
+
+namespace infini
+{
+    WeightRegionObj::WeightRegionObj(Runtime runtime, const TensorVec &weights,
+                                     size_t alignment)
+        : runtime(runtime), ptr(nullptr), size(0)
+    {
+        for (const auto &t : weights)
+        {
+            IT_ASSERT(t->isWeight());
+            if (entries.count(t->getFuid()))
+                continue;
+            size_t bytes = t->getBytes();
+            entries.emplace(t->getFuid(), pair<size_t, size_t>{size, bytes});
+            size += (bytes + alignment - 1) / alignment * alignment;
+        }
+        if (size > 0)
+            // Weights never given data read as zeros.
+            ptr = runtime->allocZeroed(size);
+    }
+
+    WeightRegionObj::~WeightRegionObj()
+    {
+        if (ptr != nullptr)
+            runtime->dealloc(ptr);
+    }
+
+    bool WeightRegionObj::contains(const Tensor &tensor) const
+    {
+        auto it = entries.find(tensor->getFuid());
+        return it != entries.end() && it->second.second == tensor->getBytes();
+    }
+
+    void *WeightRegionObj::getPtr(const Tensor &tensor) const
+    {
+        IT_ASSERT(contains(tensor), "Weight " + std::to_string(tensor->getGuid()) +
+                                        " is not held by the weight region");
+        return static_cast<char *>(ptr) + entries.at(tensor->getFuid()).first;
+    }
+
+} // namespace infini
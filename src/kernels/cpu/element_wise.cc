@@ -83,6 +83,7 @@ namespace infini
                 IT_TODO_HALT();
             }
 
+#pragma omp parallel for
             for (size_t i = 0; i < n; ++i)
             {
                 auto shapeIndexC = locate_index(i, shapeC);
@@ -25,7 +25,7 @@ class NaiveTranspose : public CpuKernelWithoutConfig {
         size_t inSize = inputs[0]->size();
         auto inPtr = inputs[0]->getRawDataPtr<T *>(),
              outPtr = outputs[0]->getRawDataPtr<T *>();
-        // #pragma omp parallel for
+#pragma omp parallel for
         for (size_t inIdx = 0; inIdx < inSize; ++inIdx) {
             auto posInput = idx2Pos(inDim, inIdx);
             int outIdx = 0;
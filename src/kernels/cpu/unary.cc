@@ -32,6 +32,7 @@ namespace infini
                 IT_TODO_HALT();
             }
 
+#pragma omp parallel for
             for (size_t offset = 0; offset < n; offset++)
             {
                 outptr[offset] = _doCompute(inptr[offset]);
@@ -70,12 +71,13 @@ namespace infini
             auto maxValue = op->getMax();
 
             auto n = op->getOutput()->size();
+#pragma omp parallel for
             for (size_t offset = 0; offset < n; offset++)
             {
-                auto val = *inptr++;
-                *outptr++ = (minValue && val < *minValue)   ? *minValue
-                            : (maxValue && val > *maxValue) ? *maxValue
-                                                            : val;
+                auto val = inptr[offset];
+                outptr[offset] = (minValue && val < *minValue)   ? *minValue
+                                 : (maxValue && val > *maxValue) ? *maxValue
+                                                                 : val;
             }
         }
 
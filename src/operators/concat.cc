@@ -39,6 +39,28 @@ optional<vector<Shape>> ConcatObj::inferShape(const TensorVec &inputs) {
     return {{dims}};
 }
 
+optional<vector<SymShape>>
+ConcatObj::inferSymbolicShape(const vector<SymShape> &inputs) const {
+    SymShape dims = inputs[0];
+    for (size_t i = 1; i < inputs.size(); ++i) {
+        IT_ASSERT(inputs[i].size() == dims.size());
+        for (size_t axis = 0; axis < dims.size(); ++axis) {
+            if ((int)axis == dim)
+                dims[axis] = dims[axis] + inputs[i][axis];
+            else if (inputs[i][axis] != dims[axis])
+                return std::nullopt;
+        }
+    }
+    return {{dims}};
+}
+
+OpCost ConcatObj::getCost() const {
+    // Pure data movement.
+    auto cost = OperatorObj::getCost();
+    cost.flops = 0;
+    return cost;
+}
+
 std::string ConcatObj::toString() const {
     std::ostringstream os;
     os << "Concat[" << getGuid() << "]";
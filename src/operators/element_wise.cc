@@ -17,6 +17,15 @@ namespace infini
         return {{res}};
     }
 
+    optional<vector<SymShape>>
+    ElementWiseObj::inferSymbolicShape(const vector<SymShape> &inputs) const
+    {
+        auto res = infer_broadcast(inputs[0], inputs[1]);
+        if (!res)
+            return std::nullopt;
+        return {{*res}};
+    }
+
     std::string ElementWiseObj::toString() const
     {
         std::ostringstream os;
@@ -18,7 +18,7 @@ namespace infini
         os << "Matmul([" << (transA ? "A^T" : "A") << "," << (transB ? "B^T" : "B]")
            << ",A=" << inputs[0]->getGuid()
            << ",B=" << inputs[1]->getGuid() << ",C=" << outputs[0]->getGuid()
-           << ",mnk=[" << m << "," << n << "," << k << "])";
+           << ",mnk=[" << getM() << "," << getN() << "," << getK() << "])";
         return os.str();
     }
 
@@ -51,10 +51,6 @@ namespace infini
 
         IT_ASSERT(kA == kB);
 
-        m = m_;
-        n = n_;
-        k = kA;
-
         Shape batchA, batchB;
         if (rankA > 2)
             batchA = Shape(dimsA.begin(), dimsA.end() - 2);
@@ -62,9 +58,55 @@ namespace infini
             batchB = Shape(dimsB.begin(), dimsB.end() - 2);
 
         Shape out = infer_broadcast(batchA, batchB);
-        out.push_back(m);
-        out.push_back(n);
+        out.push_back(m_);
+        out.push_back(n_);
         return {{out}};
     }
 
+    optional<vector<SymShape>>
+    MatmulObj::inferSymbolicShape(const vector<SymShape> &inputs) const
+    {
+        const auto &dimsA = inputs[0], &dimsB = inputs[1];
+        const size_t rankA = dimsA.size(), rankB = dimsB.size();
+        const auto &m_ = dimsA[rankA - (transA ? 1 : 2)];
+        const auto &kA = dimsA[rankA - (transA ? 2 : 1)];
+        const auto &kB = dimsB[rankB - (transB ? 1 : 2)];
+        const auto &n_ = dimsB[rankB - (transB ? 2 : 1)];
+        if (kA != kB)
+            return std::nullopt;
+        auto out = infer_broadcast(SymShape(dimsA.begin(), dimsA.end() - 2),
+                                   SymShape(dimsB.begin(), dimsB.end() - 2));
+        if (!out)
+            return std::nullopt;
+        out->push_back(m_);
+        out->push_back(n_);
+        return {{*out}};
+    }
+
+    OpCost MatmulObj::getCost() const
+    {
+        // A multiply-add per output element and step of the reduction.
+        auto cost = OperatorObj::getCost();
+        cost.flops = 2 * outputs[0]->size() * getK();
+        return cost;
+    }
+
+    int MatmulObj::getM() const
+    {
+        auto dims = inputs[0]->getDims();
+        return dims[dims.size() - (transA ? 1 : 2)];
+    }
+
+    int MatmulObj::getN() const
+    {
+        auto dims = inputs[1]->getDims();
+        return dims[dims.size() - (transB ? 2 : 1)];
+    }
+
+    int MatmulObj::getK() const
+    {
+        auto dims = inputs[0]->getDims();
+        return dims[dims.size() - (transA ? 2 : 1)];
+    }
+
 } // namespace infini
\ No newline at end of file
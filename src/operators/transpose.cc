@@ -58,6 +58,26 @@ namespace infini
         return {{output_dim}};
     }
 
+    optional<vector<SymShape>>
+    TransposeObj::inferSymbolicShape(const vector<SymShape> &inputs) const
+    {
+        // The permutation is validated by inferShape.
+        const auto &input_dim = inputs[0];
+        IT_ASSERT(transposePermute.size() == input_dim.size());
+        SymShape output_dim(input_dim.size());
+        for (size_t outAxis = 0; outAxis < output_dim.size(); ++outAxis)
+            output_dim[outAxis] = input_dim[transposePermute[outAxis]];
+        return {{output_dim}};
+    }
+
+    OpCost TransposeObj::getCost() const
+    {
+        // Pure data movement.
+        auto cost = OperatorObj::getCost();
+        cost.flops = 0;
+        return cost;
+    }
+
     std::string TransposeObj::toString() const
     {
         std::ostringstream os;
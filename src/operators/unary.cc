@@ -1,4 +1,5 @@
 #include "operators/unary.h"
+#include <cstring>
 
 namespace infini
 {
@@ -14,6 +15,12 @@ namespace infini
         return {{A->getDims()}};
     }
 
+    optional<vector<SymShape>>
+    UnaryObj::inferSymbolicShape(const vector<SymShape> &inputs) const
+    {
+        return {{inputs[0]}};
+    }
+
     std::string UnaryObj::toString() const
     {
         std::ostringstream os;
@@ -43,6 +50,36 @@ namespace infini
         return {{X->getDims()}};
     }
 
+    optional<vector<SymShape>>
+    ClipObj::inferSymbolicShape(const vector<SymShape> &inputs) const
+    {
+        return {{inputs[0]}};
+    }
+
+    optional<vector<int64_t>> ClipObj::getAttributes() const
+    {
+        // Bounds by bit pattern, with a flag for each bound that is set.
+        vector<int64_t> attributes;
+        for (const auto &bound : {minValue, maxValue})
+        {
+            uint32_t bits = 0;
+            if (bound)
+                std::memcpy(&bits, &*bound, sizeof(bits));
+            attributes.emplace_back(bound.has_value());
+            attributes.emplace_back(bits);
+        }
+        return attributes;
+    }
+
+    OpCost ClipObj::getCost() const
+    {
+        // A comparison per element and bound.
+        auto cost = OperatorObj::getCost();
+        cost.flops = outputs[0]->size() *
+                     (minValue.has_value() + maxValue.has_value());
+        return cost;
+    }
+
     std::string ClipObj::toString() const
     {
         std::ostringstream os;
@@ -81,6 +118,12 @@ namespace infini
         return {{X->getDims()}};
     }
 
+    optional<vector<SymShape>>
+    CastObj::inferSymbolicShape(const vector<SymShape> &inputs) const
+    {
+        return {{inputs[0]}};
+    }
+
     std::string CastObj::toString() const
     {
         std::ostringstream os;
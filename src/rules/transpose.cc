@@ -0,0 +1,251 @@
+#include "core/rewrite.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+
+namespace infini {
+
+static bool isSwapLastTwo(const vector<int> &perm) {
+    int rank = perm.size();
+    if (rank < 2)
+        return false;
+    for (int i = 0; i < rank - 2; ++i)
+        if (perm[i] != i)
+            return false;
+    return perm[rank - 2] == rank - 1 && perm[rank - 1] == rank - 2;
+}
+
+static bool isIdentityPerm(const vector<int> &perm) {
+    for (size_t i = 0; i < perm.size(); ++i)
+        if (perm[i] != int(i))
+            return false;
+    return true;
+}
+
+static vector<int> inversePerm(const vector<int> &perm) {
+    vector<int> inverse(perm.size());
+    for (size_t i = 0; i < perm.size(); ++i)
+        inverse[perm[i]] = i;
+    return inverse;
+}
+
+// Transpose(Transpose(x, p), q) -> Transpose(x, r) with r[i] = p[q[i]]. The
+// first transpose stays if it has other consumers.
+class ComposeTransposes : public RewriteRule {
+  public:
+    Pattern getPattern() const override {
+        return Pattern(OpType::Transpose, nullptr,
+                       {{0, Pattern(OpType::Transpose)}});
+    }
+
+    bool rewrite(GraphRewriter &rewriter,
+                 const OpVec &matched) const override {
+        auto second = as<TransposeObj>(matched[0]);
+        auto first = as<TransposeObj>(matched[1]);
+        auto p = first->getPermute(), q = second->getPermute();
+        vector<int> r(q.size());
+        for (size_t i = 0; i < q.size(); ++i)
+            r[i] = p[q[i]];
+        auto y = first->getOutput();
+        // Checked before y loses its consumer.
+        bool isOutput = rewriter.getGraph().isOutput(y);
+        second->setPermute(std::move(r));
+        rewriter.replaceUse(second, y, first->getInputs(0));
+        if (y->getTargetView().empty() && !isOutput)
+            rewriter.eraseOperator(first);
+        return true;
+    }
+};
+
+// Transpose(x, identity) -> x
+class EraseIdentityTranspose : public RewriteRule {
+  public:
+    Pattern getPattern() const override {
+        return Pattern(OpType::Transpose, [](const Operator &op) {
+            return isIdentityPerm(as<TransposeObj>(op)->getPermute());
+        });
+    }
+
+    bool rewrite(GraphRewriter &rewriter,
+                 const OpVec &matched) const override {
+        auto transpose = matched[0];
+        auto x = transpose->getInputs(0), z = transpose->getOutput();
+        const auto &graph = rewriter.getGraph();
+        // A graph output keeps its tensor: the producer of x computes it
+        // instead. Without one, the transpose is left as a copy.
+        bool keepOutput = graph.isOutput(z);
+        if (keepOutput && (!x->getSource() || graph.isOutput(x)))
+            return false;
+        rewriter.replaceAllUses(z, x);
+        rewriter.eraseOperator(transpose);
+        if (keepOutput)
+            rewriter.moveOutput(x, z);
+        return true;
+    }
+};
+
+// The transpose producing `t` if `op` is its only consumer, so that it can be
+// moved below `op`.
+static Ref<TransposeObj> sinkableTranspose(const GraphObj &graph,
+                                           const Tensor &t,
+                                           const Operator &op) {
+    auto source = t->getSource();
+    if (!source || source->getOpType() != OpType::Transpose ||
+        graph.isOutput(t))
+        return nullptr;
+    for (auto *target : t->getTargetView())
+        if (target != op.get())
+            return nullptr;
+    return as<TransposeObj>(source);
+}
+
+// Replaces `op` computing z from transposed inputs by the same op on the
+// `inputs` before the transposition followed by `transpose`.
+static void sinkBelow(GraphRewriter &rewriter, const Operator &op,
+                      const TensorVec &inputs,
+                      const Ref<TransposeObj> &transpose) {
+    auto z = op->getOutput();
+    auto perm = transpose->getPermute();
+    Shape dims(perm.size());
+    for (size_t i = 0; i < perm.size(); ++i)
+        dims[perm[i]] = z->getDims()[i];
+    auto w = rewriter.addTensor(dims, z->getDType());
+    rewriter.insertOperator(op->clone(inputs, {w}), op);
+    rewriter.insertOperator(transpose->clone({w}, {z}), op);
+    rewriter.eraseOperator(op);
+}
+
+// Unary(Transpose(x, p)) -> Transpose(Unary(x), p)
+template <OpType::underlying_t Type>
+class SinkTransposeThroughUnary : public RewriteRule {
+  public:
+    Pattern getPattern() const override {
+        return Pattern(OpType(Type), nullptr, {{0, Pattern(OpType::Transpose)}});
+    }
+
+    bool rewrite(GraphRewriter &rewriter,
+                 const OpVec &matched) const override {
+        auto op = matched[0];
+        auto transpose =
+            sinkableTranspose(rewriter.getGraph(), op->getInputs(0), op);
+        if (!transpose)
+            return false;
+        sinkBelow(rewriter, op, {transpose->getInputs(0)}, transpose);
+        rewriter.eraseOperator(transpose);
+        return true;
+    }
+};
+
+// Binary(Transpose(a, p), Transpose(b, p)) -> Transpose(Binary(a, b), p).
+// Instead of a transpose, one side may be a tensor of ones broadcast the same
+// way in both layouts, or a weight of full rank that is transposed back and
+// later folded.
+template <OpType::underlying_t Type>
+class SinkTransposeThroughBinary : public RewriteRule {
+  public:
+    Pattern getPattern() const override { return Pattern(OpType(Type)); }
+
+    bool rewrite(GraphRewriter &rewriter,
+                 const OpVec &matched) const override {
+        auto op = matched[0];
+        const auto &graph = rewriter.getGraph();
+        Ref<TransposeObj> transposes[2];
+        for (int i = 0; i < 2; ++i)
+            transposes[i] = sinkableTranspose(graph, op->getInputs(i), op);
+        auto transpose = transposes[0] ? transposes[0] : transposes[1];
+        if (!transpose)
+            return false;
+        auto perm = transpose->getPermute();
+
+        TensorVec inputs(2);
+        vector<int> weights;
+        for (int i = 0; i < 2; ++i) {
+            auto input = op->getInputs(i);
+            auto dims = input->getDims();
+            if (transposes[i] && transposes[i]->getPermute() == perm)
+                inputs[i] = transposes[i]->getInputs(0);
+            else if (std::all_of(dims.begin(), dims.end(),
+                                 [](int d) { return d == 1; }) &&
+                     dims.size() <= perm.size())
+                inputs[i] = input;
+            else if (input->isWeight() && dims.size() == perm.size())
+                weights.push_back(i);
+            else
+                return false;
+        }
+        // With only weights below the op, moving the transpose from one
+        // weight to another would loop; foldConstants evaluates it instead.
+        if (!weights.empty() &&
+            std::none_of(std::begin(transposes), std::end(transposes),
+                         [](const Ref<TransposeObj> &t) {
+                             return t && !t->getInputs(0)->isWeight();
+                         }))
+            return false;
+        auto inverse = inversePerm(perm);
+        for (int i : weights) {
+            auto weight = op->getInputs(i);
+            Shape dims(perm.size());
+            for (size_t j = 0; j < perm.size(); ++j)
+                dims[j] = weight->getDims()[inverse[j]];
+            inputs[i] = rewriter.addTensor(dims, weight->getDType());
+            rewriter.insertOperator(
+                make_ref<TransposeObj>(nullptr, weight, inputs[i], inverse), op);
+        }
+        sinkBelow(rewriter, op, inputs, transpose);
+        for (int i = 0; i < 2; ++i)
+            if (transposes[i] && !rewriter.isErased(transposes[i]) &&
+                transposes[i]->getOutput()->getTargetView().empty())
+                rewriter.eraseOperator(transposes[i]);
+        return true;
+    }
+};
+
+// MatMul(Transpose(a) swapping the last two dims, b) -> MatMul(a, b) with
+// the transposition folded into transA (or transB for the second input).
+template <int Input> class FuseTransposeIntoMatmul : public RewriteRule {
+  public:
+    Pattern getPattern() const override {
+        return Pattern(OpType::MatMul, nullptr,
+                       {{Input, Pattern(OpType::Transpose, [](const Operator &op) {
+                             return isSwapLastTwo(
+                                 as<TransposeObj>(op)->getPermute());
+                         })}});
+    }
+
+    bool rewrite(GraphRewriter &rewriter,
+                 const OpVec &matched) const override {
+        auto matmul = as<MatmulObj>(matched[0]);
+        auto transpose = matched[1];
+        auto in = transpose->getOutput();
+        // The transpose stays if it has other consumers.
+        if (in->getTargetView().size() != 1 || rewriter.getGraph().isOutput(in))
+            return false;
+        rewriter.replaceUse(matmul, in, transpose->getInputs(0));
+        if (Input == 0)
+            matmul->setTransA(!matmul->getTransA());
+        else
+            matmul->setTransB(!matmul->getTransB());
+        rewriter.eraseOperator(transpose);
+        return true;
+    }
+};
+
+} // namespace infini
+
+REGISTER_REWRITE_RULE(ComposeTransposes, "ComposeTransposes");
+REGISTER_REWRITE_RULE(EraseIdentityTranspose, "EraseIdentityTranspose");
+REGISTER_REWRITE_RULE(FuseTransposeIntoMatmul<0>, "FuseTransposeIntoMatmulA");
+REGISTER_REWRITE_RULE(FuseTransposeIntoMatmul<1>, "FuseTransposeIntoMatmulB");
+REGISTER_REWRITE_RULE(SinkTransposeThroughUnary<OpType::Relu>,
+                      "SinkTransposeThroughRelu");
+REGISTER_REWRITE_RULE(SinkTransposeThroughUnary<OpType::Clip>,
+                      "SinkTransposeThroughClip");
+REGISTER_REWRITE_RULE(SinkTransposeThroughUnary<OpType::Cast>,
+                      "SinkTransposeThroughCast");
+REGISTER_REWRITE_RULE(SinkTransposeThroughBinary<OpType::Add>,
+                      "SinkTransposeThroughAdd");
+REGISTER_REWRITE_RULE(SinkTransposeThroughBinary<OpType::Sub>,
+                      "SinkTransposeThroughSub");
+REGISTER_REWRITE_RULE(SinkTransposeThroughBinary<OpType::Mul>,
+                      "SinkTransposeThroughMul");
+REGISTER_REWRITE_RULE(SinkTransposeThroughBinary<OpType::Div>,
+                      "SinkTransposeThroughDiv");
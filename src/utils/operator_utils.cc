@@ -37,6 +37,24 @@ Shape infer_broadcast(const Shape &A, const Shape &B) {
     return out;
 }
 
+optional<SymShape> infer_broadcast(const SymShape &A, const SymShape &B) {
+    const size_t rank = std::max(A.size(), B.size());
+    SymShape out(rank, 1);
+    for (size_t i = 0; i < rank; ++i) {
+        const SymExpr aDim = i < rank - A.size() ? 1 : A[i - (rank - A.size())];
+        const SymExpr bDim = i < rank - B.size() ? 1 : B[i - (rank - B.size())];
+        // A variable may be bound to 1, so only equal dims or a constant 1
+        // broadcast for every binding.
+        if (aDim == bDim || bDim == SymExpr(1))
+            out[i] = aDim;
+        else if (aDim == SymExpr(1))
+            out[i] = bDim;
+        else
+            return std::nullopt;
+    }
+    return out;
+}
+
 int get_real_axis(const int &axis, const int &rank) {
     IT_ASSERT(rank >= 1);
     IT_ASSERT(axis >= -rank && axis <= (rank - 1));
@@ -4,6 +4,8 @@
 #include "operators/unary.h"
 
 #include "test.h"
+#include <chrono>
+#include <random>
 
 namespace infini
 {
@@ -71,4 +73,67 @@ namespace infini
         EXPECT_EQ(ptr1, ptr2);
     }
 
+    TEST(Allocator, testPlanningScale)
+    {
+        // Planning-time benchmark: tens of thousands of live blocks with
+        // interleaved frees keep the free list long.
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Allocator allocator = Allocator(runtime);
+        std::mt19937 rng(0);
+        std::uniform_int_distribution<size_t> sizeDist(1, 1 << 16);
+        std::map<size_t, size_t> live;
+        vector<pair<size_t, size_t>> blocks;
+        const int steps = 100000;
+
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < steps; ++i)
+        {
+            if (blocks.empty() || rng() % 3 != 0)
+            {
+                size_t size = sizeDist(rng);
+                blocks.emplace_back(allocator.alloc(size), size);
+            }
+            else
+            {
+                std::swap(blocks[rng() % blocks.size()], blocks.back());
+                allocator.free(blocks.back().first, blocks.back().second);
+                blocks.pop_back();
+            }
+        }
+        auto elapsed = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - begin)
+                           .count();
+        std::cout << "Planned " << steps << " alloc/free events in " << elapsed
+                  << " ms" << std::endl;
+        allocator.info();
+
+        // Live blocks never overlap.
+        for (const auto &[offset, size] : blocks)
+            live.emplace(offset, size);
+        EXPECT_EQ(live.size(), blocks.size());
+        size_t end = 0;
+        for (const auto &[offset, size] : live)
+        {
+            EXPECT_GE(offset, end);
+            end = offset + size;
+        }
+    }
+
+    TEST(Allocator, testAlignment)
+    {
+        auto runtime = make_ref<NativeCpuRuntimeObj>();
+        Allocator allocator = Allocator(runtime);
+        EXPECT_EQ(allocator.getAlignment(), 64u);
+        size_t offsetA = allocator.alloc(4);
+        size_t offsetB = allocator.alloc(100);
+        EXPECT_EQ(offsetB - offsetA, 64u);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(allocator.getPtr()) % 64, 0u);
+
+        // Arenas of at least one huge page are aligned to a huge page.
+        void *large = runtime->alloc(size_t(5) << 20);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % (size_t(2) << 20), 0u);
+        EXPECT_EQ(static_cast<char *>(large)[(size_t(5) << 20) - 1], 0);
+        runtime->dealloc(large);
+    }
+
 } // namespace infini
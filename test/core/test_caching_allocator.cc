@@ -0,0 +1,105 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+
+#include "test.h"
+
+namespace infini
+{
+    TEST(CachingAllocator, SizeClasses)
+    {
+        EXPECT_EQ(CachingAllocator::getSizeClass(1), size_t(64) << 10);
+        EXPECT_EQ(CachingAllocator::getSizeClass(size_t(64) << 10),
+                  size_t(64) << 10);
+        // Four classes between 1MiB and 2MiB.
+        EXPECT_EQ(CachingAllocator::getSizeClass((size_t(1) << 20) + 1),
+                  size_t(5) << 18);
+        EXPECT_EQ(CachingAllocator::getSizeClass(size_t(7) << 18),
+                  size_t(7) << 18);
+        EXPECT_EQ(CachingAllocator::getSizeClass((size_t(7) << 18) + 1),
+                  size_t(2) << 20);
+    }
+
+    TEST(CachingAllocator, ReuseAcrossGraphs)
+    {
+        auto &cache = CachingAllocator::getInstance();
+        cache.trim();
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto build = [&](int batch)
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            Tensor a = g->addTensor({batch, 1024}, DataType::Float32);
+            Tensor b = g->addTensor({batch, 1024}, DataType::Float32);
+            g->addOp<AddObj>(a, b, nullptr);
+            g->dataMalloc();
+            return g;
+        };
+
+        build(64);
+        auto before = cache.getStats();
+        EXPECT_GT(before.cachedBytes, 0u);
+        // Same size class: served from the cache without mapping.
+        build(60);
+        auto after = cache.getStats();
+        EXPECT_EQ(after.misses, before.misses);
+        EXPECT_GT(after.hits, before.hits);
+    }
+
+    TEST(CachingAllocator, Ceiling)
+    {
+        auto &cache = CachingAllocator::getInstance();
+        cache.trim();
+        auto base = cache.getStats();
+        ArenaOptions options;
+        options.hugePages = false;
+
+        void *p = cache.alloc(size_t(1) << 20, options);
+        void *q = cache.alloc(size_t(1) << 20, options);
+        cache.dealloc(p);
+        cache.dealloc(q);
+        EXPECT_EQ(cache.getStats().cachedBytes, size_t(2) << 20);
+
+        // Only one released arena fits under the ceiling.
+        size_t ceiling = cache.getMemoryCeiling();
+        cache.setMemoryCeiling(base.inUseBytes + (size_t(3) << 19));
+        auto stats = cache.getStats();
+        EXPECT_EQ(stats.cachedBytes, size_t(1) << 20);
+        EXPECT_EQ(stats.trimmedBytes - base.trimmedBytes, size_t(1) << 20);
+
+        void *r = cache.alloc(size_t(1) << 20, options);
+        EXPECT_EQ(cache.getStats().hits, base.hits + 1);
+        cache.dealloc(r);
+        cache.setMemoryCeiling(ceiling);
+        cache.trim();
+        EXPECT_EQ(cache.getStats().cachedBytes, 0u);
+        EXPECT_EQ(cache.getStats().inUseBytes, base.inUseBytes);
+    }
+
+    TEST(CachingAllocator, ReusedArenasZeroedOnRequest)
+    {
+        auto &cache = CachingAllocator::getInstance();
+        cache.trim();
+        ArenaOptions options;
+        options.hugePages = false;
+        const size_t size = size_t(1) << 20;
+
+        auto *p = static_cast<unsigned char *>(cache.alloc(size, options));
+        std::fill(p, p + size, 0xff);
+        cache.dealloc(p);
+        auto hits = cache.getStats().hits;
+        // Activation arenas skip the clearing.
+        auto *q = static_cast<unsigned char *>(cache.alloc(size, options));
+        EXPECT_EQ(cache.getStats().hits, hits + 1);
+        EXPECT_EQ(q, p);
+        EXPECT_EQ(q[size - 1], 0xff);
+        cache.dealloc(q);
+        options.zero = true;
+        q = static_cast<unsigned char *>(cache.alloc(size, options));
+        EXPECT_EQ(cache.getStats().hits, hits + 2);
+        EXPECT_EQ(q, p);
+        EXPECT_TRUE(std::all_of(q, q + size, [](auto b) { return b == 0; }));
+        cache.dealloc(q);
+        cache.trim();
+    }
+
+} // namespace infini
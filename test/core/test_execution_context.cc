@@ -0,0 +1,50 @@
+#include "core/execution_context.h"
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include <thread>
+
+namespace infini
+{
+    TEST(ExecutionContext, ConcurrentRuns)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 3}, DataType::Float32);
+        Tensor w = g->addTensor({2, 3}, DataType::Float32);
+        auto add = g->addOp<AddObj>(x, w, nullptr);
+        auto relu = g->addOp<ReluObj>(add->getOutput(), nullptr);
+        g->dataMalloc();
+        // Shared by every context.
+        w->setData(IncrementalGenerator());
+
+        auto ctx0 = make_ref<ExecutionContextObj>(g);
+        auto ctx1 = make_ref<ExecutionContextObj>(g);
+        ctx0->setInput(x, OneGenerator());
+        vector<float> input1(6, 10);
+        ctx1->bindInput(x, input1.data());
+
+        std::thread t0([&]
+                       { ctx0->run(); });
+        std::thread t1([&]
+                       { ctx1->run(); });
+        t0.join();
+        t1.join();
+
+        auto y = relu->getOutput();
+        EXPECT_NE(ctx0->getRawDataPtr<float *>(y),
+                  ctx1->getRawDataPtr<float *>(y));
+        {
+            ExecutionContextObj::ActiveScope scope(*ctx0);
+            EXPECT_TRUE(y->equalData(vector<float>{1, 2, 3, 4, 5, 6}));
+        }
+        {
+            ExecutionContextObj::ActiveScope scope(*ctx1);
+            EXPECT_TRUE(y->equalData(vector<float>{10, 11, 12, 13, 14, 15}));
+        }
+    }
+
+} // namespace infini
@@ -1,8 +1,11 @@
 #include "core/graph.h"
 #include "core/kernel.h"
 #include "core/runtime.h"
+#include "operators/element_wise.h"
 #include "operators/matmul.h"
 #include "operators/transpose.h"
+#include "operators/unary.h"
+#include <chrono>
 
 #include "test.h"
 
@@ -37,4 +40,305 @@ namespace infini
         EXPECT_EQ(op->getTransA(), false);
         EXPECT_EQ(op->getTransB(), true);
     }
+
+    TEST(Graph, AdjacencyViews)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 3}, DataType::Float32);
+        auto a = g->addOp<ReluObj>(x, nullptr);
+        auto b = g->addOp<ReluObj>(x, nullptr);
+        auto c = g->addOp<AddObj>(a->getOutput(), b->getOutput(), nullptr);
+        auto d = g->addOp<AddObj>(c->getOutput(), c->getOutput(), nullptr);
+
+        auto targets = x->getTargetView();
+        ASSERT_EQ(targets.size(), 2u);
+        EXPECT_EQ(targets[0], a.get());
+        EXPECT_EQ(targets[1], b.get());
+        // A consumer reading a tensor twice is listed twice.
+        EXPECT_EQ(c->getOutput()->getTargetView().size(), 2u);
+        auto preds = c->getPredecessorView();
+        EXPECT_EQ(vector<OperatorObj *>(preds.begin(), preds.end()),
+                  (vector<OperatorObj *>{a.get(), b.get()}));
+        EXPECT_EQ(d->getSuccessorView().size(), 0u);
+        // The owning getters agree with the views.
+        EXPECT_EQ(c->getPredecessors(), (OpVec{a, b}));
+        EXPECT_EQ(x->getTargets(), (OpVec{a, b}));
+    }
+
+    TEST(Graph, LargeGraphIndex)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        const int n = 200000;
+        TensorVec t;
+        for (int i = 0; i <= n; ++i)
+            t.emplace_back(g->addTensor({2, 3}, DataType::Float32));
+        // A chain added back to front, the worst case of a sweeping sort.
+        for (int i = n - 1; i >= 0; --i)
+            g->addOpWithOutputs<ReluObj>(t[i], t[i + 1]);
+
+        auto begin = std::chrono::steady_clock::now();
+        ASSERT_TRUE(g->topo_sort());
+        for (const auto &tensor : t)
+            ASSERT_EQ(g->getTensor(tensor->getFuid()), tensor);
+        g->shape_infer();
+        EXPECT_TRUE(g->checkValid());
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - begin;
+        std::cout << "Sorted and inferred " << n << " ops in "
+                  << elapsed.count() << " s" << std::endl;
+        for (int i = 0; i < n; ++i)
+            ASSERT_EQ(g->getOperators()[i]->getInputs(0), t[i]);
+
+        auto extra = g->addTensor({2, 3}, DataType::Float32);
+        g->removeTensor(extra);
+        EXPECT_EQ(g->getTensor(extra->getFuid()), nullptr);
+        EXPECT_EQ(g->getTensors().size(), size_t(n + 1));
+    }
+
+    TEST(Graph, NodeArena)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        auto build = [&](NodeStorage storage, int n)
+        {
+            Graph g = make_ref<GraphObj>(runtime, storage);
+            Tensor t = g->addTensor({2, 3}, DataType::Float32);
+            for (int i = 0; i < n; ++i)
+                t = g->addOp<ReluObj>(t, nullptr)->getOutput();
+            return g;
+        };
+        for (auto storage : {NodeStorage::Heap, NodeStorage::Arena})
+        {
+            auto begin = std::chrono::steady_clock::now();
+            build(storage, 100000);
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - begin;
+            std::cout << (storage == NodeStorage::Arena ? "Arena" : "Heap")
+                      << ": built and destroyed 100000 ops in "
+                      << elapsed.count() << " s" << std::endl;
+        }
+
+        Graph g = build(NodeStorage::Arena, 3);
+        ASSERT_NE(g->getNodeArena(), nullptr);
+        EXPECT_GT(g->getNodeArena()->getAllocatedBytes(),
+                  3 * (sizeof(ReluObj) + sizeof(TensorObj)));
+        auto x = g->getInputs()[0], y = g->getOutputs()[0];
+        g->dataMalloc();
+        x->setData(IncrementalGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(y->equalData(vector<float>{0, 1, 2, 3, 4, 5}));
+        // Nodes outlive the graph as long as they are referenced; their
+        // data lives in the graph's arena and does not.
+        g = nullptr;
+        EXPECT_EQ(y->getDims(), (Shape{2, 3}));
+    }
+
+    TEST(Graph, SurvivingTensorsDropTargets)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 3}, DataType::Float32);
+        auto relu = g->addOp<ReluObj>(x, nullptr);
+        auto y = g->addOp<ReluObj>(relu->getOutput(), nullptr)->getOutput();
+        g->removeOperator(relu);
+        EXPECT_TRUE(x->getTargets().empty());
+        EXPECT_TRUE(relu->getSuccessorView().empty());
+        EXPECT_TRUE(y->getSource()->getPredecessorView().empty());
+        relu = nullptr;
+        // x and y outlive the graph and its remaining op.
+        auto mid = y->getSource()->getInputs(0);
+        g = nullptr;
+        EXPECT_TRUE(x->getTargets().empty());
+        EXPECT_TRUE(mid->getTargets().empty());
+        EXPECT_EQ(y->getSource(), nullptr);
+
+        // A removed leaf leaves no edge behind in its producer.
+        g = make_ref<GraphObj>(runtime);
+        x = g->addTensor({2, 3}, DataType::Float32);
+        auto first = g->addOp<ReluObj>(x, nullptr);
+        auto leaf = g->addOp<ReluObj>(first->getOutput(), nullptr);
+        auto y2 = leaf->getOutput();
+        g->removeOperator(leaf);
+        g->removeTensor(y2);
+        leaf = nullptr;
+        y2 = nullptr;
+        EXPECT_TRUE(first->getSuccessorView().empty());
+        EXPECT_TRUE(first->getOutput()->getTargets().empty());
+        EXPECT_FALSE(g->toString().empty());
+        EXPECT_TRUE(g->checkValid());
+    }
+
+    TEST(Graph, IncrementalShapeInfer)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 3}, DataType::Float32);
+        Tensor w = g->addTensor({3, 4}, DataType::Float32);
+        Tensor y = g->addTensor({5, 6}, DataType::Float32);
+        auto a = g->addOp<MatmulObj>(x, w, nullptr)->getOutput();
+        a = g->addOp<ReluObj>(a, nullptr)->getOutput();
+        auto b = y;
+        for (int i = 0; i < 3; ++i)
+            b = g->addOp<ReluObj>(b, nullptr)->getOutput();
+
+        EXPECT_EQ(g->shape_infer(), 5u);
+        EXPECT_EQ(g->shape_infer(), 0u);
+        // Only the branch of y.
+        y->setShape({7, 6});
+        EXPECT_EQ(g->shape_infer(), 3u);
+        EXPECT_EQ(b->getDims(), (Shape{7, 6}));
+        // The MatMul output keeps its shape, so the Relu after it is skipped.
+        x->setShape({2, 5});
+        w->setShape({5, 4});
+        EXPECT_EQ(g->shape_infer(), 1u);
+        x->setShape({8, 5});
+        EXPECT_EQ(g->shape_infer(), 2u);
+        EXPECT_EQ(a->getDims(), (Shape{8, 4}));
+        // New ops make the next call visit every op.
+        g->addOp<ReluObj>(a, nullptr);
+        EXPECT_EQ(g->shape_infer(), 6u);
+    }
+
+    TEST(Graph, TransposeAlgebra)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 3, 4}, DataType::Float32);
+        Tensor w = g->addTensor({3, 4, 2}, DataType::Float32);
+        w->setWeight();
+        // The transpose sinks through Relu and Add (moving w back) and cancels
+        // the inverse one, which computes a graph output.
+        auto t = g->addOp<TransposeObj>(x, nullptr, vector<int>{1, 2, 0});
+        auto r = g->addOp<ReluObj>(t->getOutput(), nullptr);
+        auto a = g->addOp<AddObj>(r->getOutput(), w, nullptr);
+        auto o = g->addOp<TransposeObj>(a->getOutput(), nullptr,
+                                        vector<int>{2, 0, 1})
+                     ->getOutput();
+        // A chain composes into one permutation.
+        auto c = g->addOp<TransposeObj>(x, nullptr, vector<int>{1, 0, 2});
+        c = g->addOp<TransposeObj>(c->getOutput(), nullptr,
+                                   vector<int>{2, 1, 0});
+        g->setOutputs({o, c->getOutput()});
+        g->dataMalloc();
+        w->setData(OneGenerator());
+
+        g->optimize();
+        // Relu, Add and the composed transpose.
+        ASSERT_EQ(g->getOperators().size(), 3u);
+        EXPECT_EQ(o->getSource()->getOpType(), OpType::Add);
+        auto composed = as<TransposeObj>(c->getOutput()->getSource());
+        EXPECT_EQ(composed->getInputs(0), x);
+        EXPECT_EQ(composed->getPermute(), (vector<int>{2, 0, 1}));
+        EXPECT_TRUE(g->checkValid());
+
+        g->dataMalloc();
+        x->setData(IncrementalGenerator());
+        runtime->run(g);
+        vector<float> expected(24);
+        for (int i = 0; i < 24; ++i)
+            expected[i] = i + 1;
+        EXPECT_TRUE(o->equalData(expected));
+    }
+
+    TEST(Graph, FoldConstants)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({3, 2}, DataType::Float32);
+        Tensor w = g->addTensor({2, 3}, DataType::Float32);
+        Tensor b = g->addTensor({3, 2}, DataType::Float32);
+        w->setWeight();
+        b->setWeight();
+        // Transpose(w) + b depends on weights only.
+        auto wt = g->addOp<TransposeObj>(w, nullptr, vector<int>{1, 0});
+        auto bias = g->addOp<AddObj>(wt->getOutput(), b, nullptr);
+        auto y = g->addOp<AddObj>(x, bias->getOutput(), nullptr)->getOutput();
+        g->dataMalloc();
+        w->setData(IncrementalGenerator());
+        b->setData(OneGenerator());
+        EXPECT_EQ(g->getWeightRegion()->getNumEntries(), 2u);
+
+        EXPECT_TRUE(g->foldConstants());
+        ASSERT_EQ(g->getOperators().size(), 1u);
+        // x, the folded constant and y.
+        EXPECT_EQ(g->getTensors().size(), 3u);
+        auto folded = g->getOperators()[0]->getInputs(1);
+        EXPECT_TRUE(folded->isWeight());
+        EXPECT_TRUE(folded->equalData(vector<float>{1, 4, 2, 5, 3, 6}));
+        // The region now holds only the folded constant.
+        auto region = g->getWeightRegion();
+        EXPECT_EQ(region->getNumEntries(), 1u);
+        EXPECT_EQ(folded->getRawDataPtr<void *>(), region->getPtr(folded));
+        EXPECT_FALSE(g->foldConstants());
+
+        g->dataMalloc();
+        x->setData(OneGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(y->equalData(vector<float>{2, 5, 3, 6, 4, 7}));
+    }
+
+    TEST(Graph, EliminateCommonSubexpressions)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 3}, DataType::Float32);
+        // Two identical branches, and two Clips that differ in a bound.
+        auto t1 = g->addOp<TransposeObj>(x, nullptr, vector<int>{1, 0});
+        auto t2 = g->addOp<TransposeObj>(x, nullptr, vector<int>{1, 0});
+        auto r1 = g->addOp<ReluObj>(t1->getOutput(), nullptr);
+        auto r2 = g->addOp<ReluObj>(t2->getOutput(), nullptr);
+        auto sum = g->addOp<AddObj>(r1->getOutput(), r2->getOutput(), nullptr);
+        auto c1 = g->addOp<ClipObj>(sum->getOutput(), nullptr, 0.f, 1.f);
+        auto c2 = g->addOp<ClipObj>(sum->getOutput(), nullptr, 0.f, 2.f);
+        auto y = g->addOp<MulObj>(c1->getOutput(), c2->getOutput(), nullptr)
+                     ->getOutput();
+
+        EXPECT_TRUE(g->eliminateCommonSubexpressions());
+        EXPECT_EQ(g->getOperators().size(), 6u);
+        EXPECT_EQ(sum->getInputs(0), r1->getOutput());
+        EXPECT_EQ(sum->getInputs(1), r1->getOutput());
+        EXPECT_EQ(r1->getOutput()->getTargets().size(), 2u);
+        EXPECT_TRUE(g->checkValid());
+        EXPECT_FALSE(g->eliminateCommonSubexpressions());
+
+        g->dataMalloc();
+        x->setData(IncrementalGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(y->equalData(vector<float>{0, 2, 2, 2, 2, 2}));
+    }
+
+    TEST(Graph, EliminateDeadCode)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 3}, DataType::Float32);
+        Tensor aux = g->addTensor({2, 3}, DataType::Float32);
+        auto h = g->addOp<ReluObj>(x, nullptr)->getOutput();
+        auto y = g->addOp<AddObj>(h, x, nullptr)->getOutput();
+        // An auxiliary head reading the hidden state and its own input.
+        auto head = g->addOp<MulObj>(h, aux, nullptr)->getOutput();
+        g->addOp<ReluObj>(head, nullptr);
+        EXPECT_EQ(g->getOutputs().size(), 2u);
+        EXPECT_FALSE(g->eliminateDeadCode());
+
+        g->setOutputs({y, h});
+        EXPECT_EQ(g->getOutputs(), (TensorVec{y, h}));
+        EXPECT_TRUE(g->isOutput(h));
+        EXPECT_TRUE(g->eliminateDeadCode());
+        EXPECT_EQ(g->getOperators().size(), 2u);
+        EXPECT_EQ(g->getTensors().size(), 3u);
+        EXPECT_EQ(h->getTargets().size(), 1u);
+        EXPECT_TRUE(g->checkValid());
+
+        // h is read after the run, so it stays resident to the end.
+        g->dataMalloc();
+        for (const auto &interval : g->getMemoryPlan().intervals)
+        {
+            if (interval.tensor == h)
+            {
+                EXPECT_EQ(interval.end, 1);
+            }
+        }
+    }
 }
\ No newline at end of file
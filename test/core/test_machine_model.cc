@@ -0,0 +1,122 @@
+#include "core/data_type.h"
+#include "core/graph.h"
+#include "core/machine_model.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace infini
+{
+    TEST(MachineModel, ThreadsFor)
+    {
+        MachineModel model;
+        model.maxThreads = 8;
+        model.forkJoinNs = 4000;
+        model.bytesPerNs = 8;
+        // A streamed element reads and writes 4 bytes each: 1 ns.
+        auto streamed = [](size_t n) { return OpCost{0, 4 * n, 4 * n}; };
+        // Forking is never worth it for a few hundred elements.
+        EXPECT_EQ(model.threadsFor(streamed(0)), 1);
+        EXPECT_EQ(model.threadsFor(streamed(300)), 1);
+        // Large work uses the whole machine.
+        EXPECT_EQ(model.threadsFor(streamed(size_t(1) << 26)), 8);
+        int prev = 1;
+        for (size_t work = 1; work < (size_t(1) << 26); work *= 2)
+        {
+            int p = model.threadsFor(streamed(work));
+            EXPECT_GE(p, prev);
+            prev = p;
+        }
+    }
+
+    TEST(MachineModel, SaveLoad)
+    {
+        auto model = MachineModel::calibrate();
+        EXPECT_GE(model.maxThreads, 1);
+        EXPECT_GT(model.bytesPerNs, 0);
+        EXPECT_GT(model.flopsPerNs, 0);
+
+        string path = testing::TempDir() + "machine_model.txt";
+        std::remove(path.c_str());
+        auto stored = MachineModel::loadOrCalibrate(path);
+        auto loaded = MachineModel::load(path);
+        ASSERT_TRUE(loaded.has_value());
+        EXPECT_EQ(loaded->maxThreads, stored.maxThreads);
+        OpCost cost{1 << 20, 1 << 22, 1 << 22};
+        EXPECT_EQ(loaded->threadsFor(cost), stored.threadsFor(cost));
+        std::remove(path.c_str());
+    }
+
+    TEST(MachineModel, DefaultCachePath)
+    {
+        const char *saved = std::getenv("INFINI_MACHINE_MODEL");
+        const char *savedCache = std::getenv("XDG_CACHE_HOME");
+        string oldPath = saved ? saved : "",
+               oldCache = savedCache ? savedCache : "";
+        unsetenv("INFINI_MACHINE_MODEL");
+        string cache = testing::TempDir() + "xdg_cache";
+        setenv("XDG_CACHE_HOME", cache.c_str(), 1);
+        string path = cache + "/infinitensor/machine_model.txt";
+        EXPECT_EQ(MachineModel::getDefaultPath(), path);
+        std::remove(path.c_str());
+
+        // Calibrated once, then loaded from the cache.
+        auto first = MachineModel::loadOrCalibrate();
+        auto stored = MachineModel::load(path);
+        ASSERT_TRUE(stored.has_value());
+        EXPECT_EQ(MachineModel::loadOrCalibrate().toString(),
+                  stored->toString());
+        EXPECT_EQ(first.maxThreads, stored->maxThreads);
+        std::remove(path.c_str());
+
+        setenv("INFINI_MACHINE_MODEL", "", 1);
+        EXPECT_EQ(MachineModel::getDefaultPath(), "");
+        if (saved)
+            setenv("INFINI_MACHINE_MODEL", oldPath.c_str(), 1);
+        else
+            unsetenv("INFINI_MACHINE_MODEL");
+        if (savedCache)
+            setenv("XDG_CACHE_HOME", oldCache.c_str(), 1);
+        else
+            unsetenv("XDG_CACHE_HOME");
+    }
+
+    TEST(MachineModel, OpCost)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor a = g->addTensor({2, 3, 4}, DataType::Float32);
+        Tensor b = g->addTensor({4, 5}, DataType::Float32);
+        auto matmul = g->addOp<MatmulObj>(a, b, nullptr);
+        auto cost = matmul->getCost();
+        EXPECT_EQ(cost.flops, 2u * 30 * 4);
+        EXPECT_EQ(cost.bytesRead, (24u + 20) * 4);
+        EXPECT_EQ(cost.bytesWritten, 30u * 4);
+        auto clip = g->addOp<ClipObj>(a, nullptr, 0.f, 6.f);
+        EXPECT_EQ(clip->getCost().flops, 2u * 24);
+        auto transpose = g->addOp<TransposeObj>(a, nullptr, vector<int>{0, 2, 1});
+        EXPECT_EQ(transpose->getCost().getArithmeticIntensity(), 0.);
+        EXPECT_GT(cost.getArithmeticIntensity(),
+                  clip->getCost().getArithmeticIntensity());
+
+        MachineModel model;
+        model.maxThreads = 4;
+        model.forkJoinNs = 8;
+        model.bytesPerNs = 10;
+        model.flopsPerNs = 100;
+        OpCost streaming{1000, 100, 100};
+        // Memory bound: 200 bytes at 10 bytes/ns.
+        EXPECT_DOUBLE_EQ(model.predictNs(streaming), 20);
+        EXPECT_DOUBLE_EQ(model.predictNs(streaming, 4), 20. / 4 + 8);
+        // 20 / p + 2 * p is smallest at p = 3.
+        EXPECT_EQ(model.threadsFor(streaming), 3);
+        OpCost compute{100000, 100, 100};
+        EXPECT_DOUBLE_EQ(model.predictNs(compute), 1000);
+        EXPECT_EQ(model.threadsFor(compute), 4);
+    }
+
+} // namespace infini
@@ -0,0 +1,337 @@
+#include "core/graph.h"
+#include "core/memory_planner.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/unary.h"
+
+#include "test.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace infini
+{
+    static bool isValidPlan(const MemoryPlan &plan)
+    {
+        const auto &iv = plan.intervals;
+        for (size_t i = 0; i < iv.size(); ++i)
+        {
+            if (plan.offsets[i] + iv[i].bytes > plan.peak)
+                return false;
+            for (size_t j = i + 1; j < iv.size(); ++j)
+                if (iv[i].overlaps(iv[j]) &&
+                    plan.offsets[i] < plan.offsets[j] + iv[j].bytes &&
+                    plan.offsets[j] < plan.offsets[i] + iv[i].bytes)
+                    return false;
+        }
+        return true;
+    }
+
+    TEST(MemoryPlanner, OfflineBeatsOnline)
+    {
+        MemoryPlanner planner;
+        planner.addInterval(nullptr, 64, 0, 1);
+        planner.addInterval(nullptr, 128, 1, 2);
+        planner.addInterval(nullptr, 128, 2, 3);
+        EXPECT_EQ(planner.lowerBound(), 256u);
+
+        // The online replay leaves a 64-byte hole that the last buffer
+        // cannot use.
+        auto online = planner.solve(PlanStrategy::OnlineBestFit);
+        EXPECT_TRUE(isValidPlan(online));
+        EXPECT_EQ(online.peak, 320u);
+
+        for (auto strategy : MemoryPlanner::allStrategies())
+        {
+            auto plan = planner.solve(strategy);
+            EXPECT_TRUE(isValidPlan(plan)) << toString(strategy);
+            EXPECT_GE(plan.peak, plan.lowerBound);
+        }
+        auto best = planner.solve(MemoryPlanner::allStrategies());
+        EXPECT_EQ(best.peak, 256u);
+        EXPECT_EQ(best.gap(), 0.);
+    }
+
+    TEST(MemoryPlanner, GraphPlan)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i0 = g->addTensor({64}, DataType::Float32);
+        Tensor i1 = g->addTensor({64}, DataType::Float32);
+        auto t = g->addOp<AddObj>(i0, i1, nullptr)->getOutput();
+        for (int i = 0; i < 4; ++i)
+            t = g->addOp<ReluObj>(t, nullptr)->getOutput();
+        g->dataMalloc();
+
+        const auto &plan = g->getMemoryPlan();
+        EXPECT_TRUE(isValidPlan(plan));
+        EXPECT_EQ(plan.intervals.size(), g->getTensors().size());
+        // Two inputs, the output and one intermediate are live at once.
+        EXPECT_EQ(plan.lowerBound, 4 * 64 * sizeof(float));
+        EXPECT_EQ(plan.peak, plan.lowerBound);
+    }
+
+    TEST(MemoryPlanner, ReplanForInputShapes)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 16}, DataType::Float32);
+        Tensor w = g->addTensor({16}, DataType::Float32);
+        w->setWeight();
+        auto add = g->addOp<AddObj>(x, w, nullptr);
+        auto relu = g->addOp<ReluObj>(add->getOutput(), nullptr);
+        g->dataMalloc();
+        w->setData(OneGenerator());
+        size_t smallPeak = g->getArenaSize();
+
+        auto runWithBatch = [&](int batch)
+        {
+            x->setShape({batch, 16});
+            g->shape_infer();
+            g->dataMalloc();
+            x->setData(IncrementalGenerator());
+            runtime->run(g);
+            vector<float> expected(batch * 16);
+            for (size_t i = 0; i < expected.size(); ++i)
+                expected[i] = i + 1;
+            EXPECT_TRUE(relu->getOutput()->equalData(expected));
+        };
+
+        runWithBatch(8);
+        size_t largePeak = g->getArenaSize();
+        EXPECT_GT(largePeak, smallPeak);
+        auto arenaBase = [&]
+        {
+            return x->getRawDataPtr<char *>() -
+                   g->getTensorOffsets().at(x.get());
+        };
+        char *arena = arenaBase();
+
+        // Alternating shapes hit the plan cache and the grown arena.
+        for (int i = 0; i < 3; ++i)
+        {
+            runWithBatch(2);
+            EXPECT_EQ(g->getArenaSize(), smallPeak);
+            runWithBatch(8);
+            EXPECT_EQ(g->getArenaSize(), largePeak);
+        }
+        EXPECT_EQ(g->getPlanCacheSize(), 2u);
+        EXPECT_EQ(arenaBase(), arena);
+    }
+
+    TEST(MemoryPlanner, Report)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor i0 = g->addTensor({2, 32}, DataType::Float32);
+        Tensor i1 = g->addTensor({2, 32}, DataType::Float32);
+        auto t0 = g->addOp<AddObj>(i0, i1, nullptr)->getOutput();
+        auto t1 = g->addOp<ReluObj>(t0, nullptr)->getOutput();
+        g->addOp<ReluObj>(t1, nullptr);
+        g->dataMalloc();
+
+        auto report = g->getMemoryReport();
+        const size_t bytes = 64 * sizeof(float);
+        EXPECT_EQ(report.ops, (vector<string>{"Add", "Relu", "Relu"}));
+        EXPECT_EQ(report.liveBytes, (vector<size_t>{3 * bytes, 4 * bytes,
+                                                    4 * bytes}));
+        EXPECT_EQ(report.peakStep, 1);
+        EXPECT_EQ(report.arenaSize, g->getArenaSize());
+        EXPECT_DOUBLE_EQ(report.getFragmentation(),
+                         1. - 4. * bytes / report.arenaSize);
+        for (const auto &t : report.tensors)
+            if (t.fuid == t0->getFuid())
+            {
+                EXPECT_EQ(t.offset, g->getTensorOffsets().at(t0.get()));
+                EXPECT_EQ(t.firstOp, 0);
+                EXPECT_EQ(t.lastOp, 1);
+            }
+
+        auto csv = report.toCsv();
+        EXPECT_EQ(std::count(csv.begin(), csv.end(), '\n'),
+                  1 + long(g->getTensors().size()));
+        EXPECT_NE(csv.find(",Float32,2x32,"), string::npos);
+        auto json = report.toJson();
+        EXPECT_EQ(json.front(), '{');
+        EXPECT_NE(json.find("\"peak_step\":1"), string::npos);
+        EXPECT_NE(json.find("\"dims\":[2,32]"), string::npos);
+    }
+
+    TEST(MemoryPlanner, ParallelStages)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({64}, DataType::Float32);
+        Tensor y = g->addTensor({64}, DataType::Float32);
+        // Two independent branches joined by an add.
+        auto a = g->addOp<ReluObj>(x, nullptr)->getOutput();
+        a = g->addOp<ReluObj>(a, nullptr)->getOutput();
+        auto b = g->addOp<ReluObj>(y, nullptr)->getOutput();
+        b = g->addOp<ReluObj>(b, nullptr)->getOutput();
+        auto out = g->addOp<AddObj>(a, b, nullptr)->getOutput();
+
+        g->dataMalloc();
+        const size_t sequentialPeak = g->getArenaSize();
+        EXPECT_EQ(g->getStages().size(), 6u);
+
+        g->setParallelism(2);
+        g->dataMalloc();
+        EXPECT_EQ(g->getStages(), (vector<size_t>{0, 2, 4, 5}));
+        const auto &plan = g->getMemoryPlan();
+        EXPECT_TRUE(isValidPlan(plan));
+        // Both branches are live in every stage they run concurrently.
+        for (const auto &interval : plan.intervals)
+        {
+            auto source = interval.tensor->getSource();
+            if (source && source->getOpType() == OpType::Relu)
+            {
+                EXPECT_EQ(interval.end - interval.begin, 1);
+            }
+        }
+        EXPECT_GE(g->getArenaSize(), sequentialPeak);
+
+        x->setData(IncrementalGenerator());
+        y->setData(OneGenerator());
+        runtime->run(g);
+        vector<float> expected(64);
+        for (int i = 0; i < 64; ++i)
+            expected[i] = i + 1;
+        EXPECT_TRUE(out->equalData(expected));
+    }
+
+    TEST(MemoryPlanner, ParallelStageThrows)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({64}, DataType::Float32);
+        Tensor a = g->addTensor({4, 8}, DataType::Float32);
+        Tensor b = g->addTensor({8, 4}, DataType::Float32);
+        g->addOp<ReluObj>(x, nullptr);
+        // No CPU kernel is registered for Matmul.
+        g->addOp<MatmulObj>(a, b, nullptr);
+        g->setParallelism(2);
+        g->dataMalloc();
+        ASSERT_EQ(g->getStages(), (vector<size_t>{0, 2}));
+        EXPECT_THROW(runtime->run(g), Exception);
+
+        // A failing op run alone leaves the caller's thread count as it was.
+        Graph h = make_ref<GraphObj>(runtime);
+        Tensor hx = h->addTensor({64}, DataType::Float32);
+        Tensor ha = h->addTensor({4, 8}, DataType::Float32);
+        Tensor hb = h->addTensor({8, 4}, DataType::Float32);
+        h->addOp<ReluObj>(hx, nullptr);
+        h->addOp<MatmulObj>(ha, hb, nullptr);
+        h->dataMalloc();
+#ifdef _OPENMP
+        const int threads = omp_get_max_threads();
+        // More threads than the tiny Relu picks for itself.
+        omp_set_num_threads(threads + 3);
+        EXPECT_THROW(runtime->run(h), Exception);
+        EXPECT_EQ(omp_get_max_threads(), threads + 3);
+        omp_set_num_threads(threads);
+#else
+        EXPECT_THROW(runtime->run(h), Exception);
+#endif
+    }
+
+    TEST(MemoryPlanner, RecomputeUnderBudget)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({64}, DataType::Float32);
+        // `a` is used right away and again at the very end.
+        auto a = g->addOp<ReluObj>(x, nullptr)->getOutput();
+        auto c1 = g->addOp<AddObj>(x, a, nullptr)->getOutput();
+        auto d = g->addOp<ReluObj>(x, nullptr)->getOutput();
+        auto c2 = g->addOp<AddObj>(c1, d, nullptr)->getOutput();
+        auto c3 = g->addOp<ReluObj>(c2, nullptr)->getOutput();
+        auto out = g->addOp<AddObj>(a, c3, nullptr)->getOutput();
+        const size_t bytes = 64 * sizeof(float);
+
+        g->dataMalloc();
+        EXPECT_EQ(g->getArenaSize(), 5 * bytes);
+
+        g->setMemoryBudget(4 * bytes);
+        g->dataMalloc();
+        EXPECT_LE(g->getArenaSize(), 4 * bytes);
+        EXPECT_TRUE(isValidPlan(g->getMemoryPlan()));
+        // One extra Relu recomputes `a` right before the last add.
+        const auto &ops = g->getOperators();
+        ASSERT_EQ(ops.size(), 7u);
+        EXPECT_EQ(ops[5]->getOpType(), OpType::Relu);
+        EXPECT_EQ(ops[6]->getInputs(0), ops[5]->getOutput());
+        EXPECT_EQ(a->getTargets().size(), 1u);
+        // The plan is reused as is on the next call.
+        auto planned = g->getMemoryPlan();
+        OpVec order = ops;
+        g->dataMalloc();
+        EXPECT_EQ(g->getOperators(), order);
+        EXPECT_EQ(g->getMemoryPlan().offsets, planned.offsets);
+
+        x->setData(IncrementalGenerator());
+        runtime->run(g);
+        vector<float> expected(64);
+        for (int i = 0; i < 64; ++i)
+            expected[i] = 4 * i;
+        EXPECT_TRUE(out->equalData(expected));
+
+        // A budget that cannot be met leaves the graph unchanged.
+        g->setMemoryBudget(2 * bytes);
+        auto numTensors = g->getTensors().size();
+        EXPECT_THROW(g->dataMalloc(), Exception);
+        EXPECT_EQ(g->getOperators().size(), 7u);
+        EXPECT_EQ(g->getTensors().size(), numTensors);
+        EXPECT_TRUE(g->checkValid());
+
+        Graph h = make_ref<GraphObj>(runtime);
+        Tensor hx = h->addTensor({64}, DataType::Float32);
+        auto ha = h->addOp<ReluObj>(hx, nullptr)->getOutput();
+        auto hc1 = h->addOp<AddObj>(hx, ha, nullptr)->getOutput();
+        auto hd = h->addOp<ReluObj>(hx, nullptr)->getOutput();
+        auto hc2 = h->addOp<AddObj>(hc1, hd, nullptr)->getOutput();
+        auto hc3 = h->addOp<ReluObj>(hc2, nullptr)->getOutput();
+        h->addOp<AddObj>(ha, hc3, nullptr);
+        h->setMemoryBudget(3 * bytes);
+        EXPECT_THROW(h->dataMalloc(), Exception);
+        EXPECT_EQ(h->getOperators().size(), 6u);
+        EXPECT_EQ(h->getTensors().size(), 7u);
+        EXPECT_EQ(ha->getTargets().size(), 2u);
+        EXPECT_TRUE(h->checkValid());
+    }
+
+    TEST(MemoryPlanner, ReorderForMemory)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({64}, DataType::Float32);
+        // Four branches added breadth-first: all of them are live at once.
+        TensorVec a, b;
+        for (int i = 0; i < 4; ++i)
+            a.emplace_back(g->addOp<ReluObj>(x, nullptr)->getOutput());
+        for (int i = 0; i < 4; ++i)
+            b.emplace_back(g->addOp<ReluObj>(a[i], nullptr)->getOutput());
+        auto out = b[0];
+        for (int i = 1; i < 4; ++i)
+            out = g->addOp<AddObj>(out, b[i], nullptr)->getOutput();
+        const size_t bytes = 64 * sizeof(float);
+
+        // Depth-first, each branch is reduced before the next one starts.
+        EXPECT_TRUE(g->reorderForMemory());
+        EXPECT_FALSE(g->reorderForMemory());
+        const auto &ops = g->getOperators();
+        EXPECT_EQ(ops[1]->getInputs(0), ops[0]->getOutput());
+        EXPECT_EQ(ops[4]->getOpType(), OpType::Add);
+
+        g->dataMalloc();
+        EXPECT_TRUE(isValidPlan(g->getMemoryPlan()));
+        EXPECT_EQ(g->getMemoryReport().getPeakLiveBytes(), 4 * bytes);
+        x->setData(IncrementalGenerator());
+        runtime->run(g);
+        vector<float> expected(64);
+        for (int i = 0; i < 64; ++i)
+            expected[i] = 4 * i;
+        EXPECT_TRUE(out->equalData(expected));
+    }
+
+} // namespace infini
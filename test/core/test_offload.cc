@@ -0,0 +1,110 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/unary.h"
+
+#include "test.h"
+
+namespace infini
+{
+    TEST(Offload, Split)
+    {
+        OffloadOptions options;
+        options.minIdleSteps = 3;
+        options.prefetchSteps = 2;
+        using Segments = vector<pair<int, int>>;
+        EXPECT_EQ(OffloaderObj::split(options, 0, 9, {1, 3, 9}),
+                  (Segments{{0, 3}, {7, 9}}));
+        EXPECT_EQ(OffloaderObj::split(options, 2, 9, {4, 6}),
+                  (Segments{{2, 9}}));
+        // The distance derived from the schedule is a quarter of the span.
+        options.prefetchSteps = 0;
+        EXPECT_EQ(OffloaderObj::split(options, 0, 20, {20}),
+                  (Segments{{0, 0}, {16, 20}}));
+    }
+
+    TEST(Offload, RunThroughScratchFile)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({64}, DataType::Float32);
+        // `a` is idle while the chain runs.
+        auto a = g->addOp<ReluObj>(x, nullptr)->getOutput();
+        auto c = g->addOp<AddObj>(a, x, nullptr)->getOutput();
+        for (int i = 0; i < 5; ++i)
+            c = g->addOp<ReluObj>(c, nullptr)->getOutput();
+        auto out = g->addOp<AddObj>(a, c, nullptr)->getOutput();
+
+        OffloadOptions options;
+        options.minBytes = 0;
+        options.minIdleSteps = 2;
+        options.prefetchSteps = 1;
+        g->setOffloadOptions(options);
+        g->dataMalloc();
+        ASSERT_NE(g->getOffloader(), nullptr);
+        EXPECT_EQ(g->getOffloader()->getNumTensors(), 1u);
+        int segments = 0;
+        for (const auto &interval : g->getMemoryPlan().intervals)
+            segments += interval.tensor == a;
+        EXPECT_EQ(segments, 2);
+        // Only x and two links of the chain are resident mid-chain.
+        EXPECT_EQ(g->getMemoryReport().liveBytes[4], 3 * 64 * sizeof(float));
+
+        for (float scale : {1.f, 2.f})
+        {
+            x->setData([&](void *ptr, size_t size, DataType)
+                       {
+                           auto data = static_cast<float *>(ptr);
+                           for (size_t i = 0; i < size; ++i)
+                               data[i] = scale * i;
+                       });
+            runtime->run(g);
+            vector<float> expected(64);
+            for (int i = 0; i < 64; ++i)
+                expected[i] = 3 * scale * i;
+            EXPECT_TRUE(out->equalData(expected));
+        }
+
+        g->setOffloadOptions(std::nullopt);
+        g->dataMalloc();
+        EXPECT_EQ(g->getOffloader(), nullptr);
+    }
+
+    TEST(Offload, InputsStayResident)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({64}, DataType::Float32);
+        // x is idle during the whole chain but is written by the caller.
+        auto c = x;
+        for (int i = 0; i < 7; ++i)
+            c = g->addOp<ReluObj>(c, nullptr)->getOutput();
+        auto out = g->addOp<AddObj>(c, x, nullptr)->getOutput();
+
+        OffloadOptions options;
+        options.minBytes = 0;
+        options.minIdleSteps = 2;
+        g->setOffloadOptions(options);
+        g->dataMalloc();
+        int segments = 0;
+        for (const auto &interval : g->getMemoryPlan().intervals)
+            segments += interval.tensor == x;
+        EXPECT_EQ(segments, 1);
+
+        for (float scale : {1.f, 2.f, 3.f, 4.f})
+        {
+            x->setData([&](void *ptr, size_t size, DataType)
+                       {
+                           auto data = static_cast<float *>(ptr);
+                           for (size_t i = 0; i < size; ++i)
+                               data[i] = scale * i;
+                       });
+            runtime->run(g);
+            vector<float> expected(64);
+            for (int i = 0; i < 64; ++i)
+                expected[i] = 2 * scale * i;
+            EXPECT_TRUE(out->equalData(expected));
+        }
+    }
+
+} // namespace infini
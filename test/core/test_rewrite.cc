@@ -0,0 +1,115 @@
+#include "core/graph.h"
+#include "core/rewrite.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+#include <chrono>
+
+#include "test.h"
+
+namespace infini
+{
+    // Relu(Relu(x)) -> Relu(x)
+    class EraseReluOfRelu : public RewriteRule
+    {
+    public:
+        Pattern getPattern() const override
+        {
+            return Pattern(OpType::Relu, nullptr, {{0, Pattern(OpType::Relu)}});
+        }
+
+        bool rewrite(GraphRewriter &rewriter,
+                     const OpVec &matched) const override
+        {
+            auto outer = matched[0], inner = matched[1];
+            if (outer->getOutput()->getTargets().empty())
+                return false;
+            rewriter.replaceAllUses(outer->getOutput(), inner->getOutput());
+            rewriter.eraseOperator(outer);
+            return true;
+        }
+    };
+
+} // namespace infini
+
+REGISTER_REWRITE_RULE(EraseReluOfRelu, "EraseReluOfRelu");
+
+namespace infini
+{
+    TEST(Rewrite, PatternMatch)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 3}, DataType::Float32);
+        auto t = g->addOp<TransposeObj>(x, nullptr, vector<int>{1, 0});
+        auto r = g->addOp<ReluObj>(t->getOutput(), nullptr);
+
+        Pattern pattern(OpType::Relu, nullptr,
+                        {{0, Pattern(OpType::Transpose,
+                                     [](const Operator &op)
+                                     {
+                                         return as<TransposeObj>(op)
+                                                    ->getPermute()[0] == 1;
+                                     })}});
+        OpVec matched;
+        EXPECT_TRUE(pattern.match(r, matched));
+        EXPECT_EQ(matched, (OpVec{r, t}));
+        matched.clear();
+        EXPECT_FALSE(pattern.match(t, matched));
+        EXPECT_TRUE(matched.empty());
+    }
+
+    TEST(Rewrite, WeightOnlyBinary)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor w1 = g->addTensor({2, 3}, DataType::Float32);
+        Tensor w2 = g->addTensor({3, 2}, DataType::Float32);
+        w1->setWeight();
+        w2->setWeight();
+        auto t = g->addOp<TransposeObj>(w1, nullptr, vector<int>{1, 0});
+        auto y = g->addOp<AddObj>(t->getOutput(), w2, nullptr)->getOutput();
+
+        // Sinking would only move the transpose between the weights.
+        g->optimize();
+        ASSERT_EQ(g->getOperators().size(), 2u);
+        EXPECT_EQ(g->getOperators()[1]->getOutput(), y);
+        EXPECT_TRUE(g->checkValid());
+    }
+
+    TEST(Rewrite, LargeGraph)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 3}, DataType::Float32);
+        // Runs of Relus separated by inverse Transpose pairs collapse once the
+        // pairs are gone.
+        const int blocks = 25000;
+        Tensor t = x;
+        for (int i = 0; i < blocks; ++i)
+        {
+            t = g->addOp<ReluObj>(t, nullptr)->getOutput();
+            t = g->addOp<ReluObj>(t, nullptr)->getOutput();
+            t = g->addOp<TransposeObj>(t, nullptr, vector<int>{1, 0})
+                    ->getOutput();
+            t = g->addOp<TransposeObj>(t, nullptr, vector<int>{1, 0})
+                    ->getOutput();
+        }
+        auto out = g->addOp<ReluObj>(t, nullptr)->getOutput();
+
+        auto begin = std::chrono::steady_clock::now();
+        g->optimize();
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - begin;
+        std::cout << "Optimized " << 4 * blocks + 1 << " ops in "
+                  << elapsed.count() << " s" << std::endl;
+
+        // The first Relu and the output Relu remain.
+        ASSERT_EQ(g->getOperators().size(), 2u);
+        EXPECT_EQ(g->getTensors().size(), 3u);
+        EXPECT_EQ(g->getOperators()[1]->getOutput(), out);
+        EXPECT_TRUE(g->checkValid());
+    }
+
+} // namespace infini
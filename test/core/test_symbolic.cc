@@ -0,0 +1,108 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/concat.h"
+#include "operators/element_wise.h"
+#include "operators/matmul.h"
+#include "operators/transpose.h"
+#include "operators/unary.h"
+
+#include "test.h"
+
+namespace infini
+{
+    TEST(Symbolic, Expressions)
+    {
+        auto b = SymExpr::var("b"), s = SymExpr::var("s");
+        auto e = SymExpr(2) * b * s + 4;
+        EXPECT_EQ(e.toString(), "2*b*s + 4");
+        EXPECT_EQ(e.evaluate({{"b", 3}, {"s", 5}}), 34);
+        EXPECT_EQ((b + 1) * (b - 1), b * b - 1);
+        EXPECT_EQ((b - b + 3).getConstant(), optional<int64_t>(3));
+        EXPECT_FALSE(e.getConstant().has_value());
+        EXPECT_EQ(toString(SymShape{b, s - 1}), "[b,s - 1]");
+        EXPECT_THROW(e.evaluate({{"b", 3}}), Exception);
+    }
+
+    TEST(Symbolic, InferShapes)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto b = SymExpr::var("b"), s = SymExpr::var("s");
+        Tensor x = g->addTensor({2, 3, 8}, DataType::Float32);
+        Tensor w = g->addTensor({8, 16}, DataType::Float32);
+        Tensor bias = g->addTensor({1, 16}, DataType::Float32);
+        x->setSymbolicShape(SymShape{b, s, 8});
+        auto matmul = g->addOp<MatmulObj>(x, w, nullptr);
+        auto y = g->addOp<AddObj>(matmul->getOutput(), bias, nullptr)->getOutput();
+        auto t = g->addOp<TransposeObj>(y, nullptr, vector<int>{0, 2, 1})
+                     ->getOutput();
+        auto c = g->addOp<ConcatObj>(TensorVec{t, t}, nullptr, 2)->getOutput();
+
+        g->inferSymbolicShapes();
+        EXPECT_EQ(*c->getSymbolicShape(), (SymShape{b, 16, s * 2}));
+        g->bindDims({{"b", 4}, {"s", 5}});
+        EXPECT_EQ(c->getDims(), (Shape{4, 16, 10}));
+        EXPECT_EQ(matmul->getM(), 5);
+        // shape_infer agrees and has nothing left to do.
+        g->shape_infer();
+        g->bindDims({{"b", 1}, {"s", 7}});
+        EXPECT_EQ(g->shape_infer(), 0u);
+        EXPECT_EQ(c->getDims(), (Shape{1, 16, 14}));
+
+        // b may be bound to 1, so [b] and [s] do not provably broadcast.
+        Tensor z = g->addTensor({3}, DataType::Float32);
+        z->setSymbolicShape(SymShape{s});
+        auto u = g->addTensor({3}, DataType::Float32);
+        u->setSymbolicShape(SymShape{b});
+        g->addOp<AddObj>(z, u, nullptr);
+        EXPECT_THROW(g->inferSymbolicShapes(), Exception);
+    }
+
+    TEST(Symbolic, PlanForEveryBatchSize)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        auto b = SymExpr::var("b");
+        Tensor x = g->addTensor({2, 4}, DataType::Float32);
+        x->setSymbolicShape(SymShape{b, 4});
+        auto r = g->addOp<ReluObj>(x, nullptr)->getOutput();
+        auto c = g->addOp<ConcatObj>(TensorVec{r, x}, nullptr, 0)->getOutput();
+        auto t = g->addOp<TransposeObj>(c, nullptr, vector<int>{1, 0})
+                     ->getOutput();
+        auto out = g->addOp<ReluObj>(t, nullptr)->getOutput();
+        g->inferSymbolicShapes();
+
+        for (int batch : {2, 5, 3, 8})
+        {
+            g->bindDims({{"b", batch}});
+            g->dataMalloc();
+            const auto &plan = g->getMemoryPlan();
+            EXPECT_GE(plan.peak, plan.lowerBound);
+            for (size_t i = 0; i < plan.intervals.size(); ++i)
+            {
+                const auto &a = plan.intervals[i];
+                EXPECT_GE(a.bytes, a.tensor->getBytes());
+                for (size_t j = 0; j < i; ++j)
+                {
+                    const auto &o = plan.intervals[j];
+                    if (a.overlaps(o))
+                    {
+                        EXPECT_TRUE(plan.offsets[i] >= plan.offsets[j] + o.bytes ||
+                                    plan.offsets[j] >= plan.offsets[i] + a.bytes);
+                    }
+                }
+            }
+
+            x->setData(IncrementalGenerator());
+            runtime->run(g);
+            // out[j][i] = c[i][j], with the rows of x stacked twice.
+            vector<float> expected(8 * batch);
+            for (int j = 0; j < 4; ++j)
+                for (int i = 0; i < 2 * batch; ++i)
+                    expected[j * 2 * batch + i] = (i % batch) * 4 + j;
+            EXPECT_TRUE(out->equalData(expected));
+        }
+        EXPECT_EQ(g->getPlanCacheSize(), 4u);
+    }
+
+} // namespace infini
@@ -0,0 +1,86 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "core/weight_file.h"
+#include "operators/element_wise.h"
+
+#include "test.h"
+#include <cstdio>
+#include <fstream>
+
+namespace infini
+{
+    TEST(WeightFile, ZeroCopyLoad)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        string path = testing::TempDir() + "weights.itw";
+        {
+            Graph g = make_ref<GraphObj>(runtime);
+            Tensor w = g->addTensor({2, 3}, DataType::Float32);
+            Tensor b = g->addTensor({3}, DataType::Float32);
+            w->setWeight();
+            b->setWeight();
+            g->addOp<AddObj>(w, b, nullptr);
+            g->dataMalloc();
+            w->setData(IncrementalGenerator());
+            b->setData(OneGenerator());
+            WeightFileObj::save(path, {{"w", w}, {"b", b}});
+        }
+
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({2, 3}, DataType::Float32);
+        Tensor w = g->addTensor({2, 3}, DataType::Float32);
+        Tensor b = g->addTensor({3}, DataType::Float32);
+        auto mul = g->addOp<MulObj>(x, w, nullptr);
+        auto add = g->addOp<AddObj>(mul->getOutput(), b, nullptr);
+        {
+            auto file = WeightFileObj::open(runtime, path);
+            EXPECT_EQ(file->getNames().size(), 2u);
+            file->bind(w, "w");
+            file->bind(b, "b");
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(w->getRawDataPtr<void *>()) %
+                          WeightFileObj::dataAlignment,
+                      0u);
+            EXPECT_THROW(file->bind(x, "b"), Exception);
+        }
+        // Tensors keep the mapping alive; no weight region is needed.
+        g->dataMalloc();
+        EXPECT_EQ(g->getWeightRegion(), nullptr);
+        x->setData(OneGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(add->getOutput()->equalData(vector<float>{1, 2, 3, 4, 5, 6}));
+        std::remove(path.c_str());
+    }
+
+    TEST(WeightFile, RejectsCorruptedEntries)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        string path = testing::TempDir() + "corrupted.itw";
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor w = g->addTensor({2, 3}, DataType::Float32);
+        g->dataMalloc();
+        w->setData(IncrementalGenerator());
+
+        // Entry fields after the 16-byte header and the one-byte name "w".
+        const size_t dtypeAt = 21, offsetAt = 37, bytesAt = 45;
+        auto corrupt = [&](size_t at, auto value)
+        {
+            WeightFileObj::save(path, {{"w", w}});
+            std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+            fs.seekp(at);
+            fs.write(reinterpret_cast<const char *>(&value), sizeof(value));
+        };
+        corrupt(dtypeAt, int32_t(99));
+        EXPECT_THROW(WeightFileObj::open(runtime, path), Exception);
+        corrupt(dtypeAt, int32_t(-1));
+        EXPECT_THROW(WeightFileObj::open(runtime, path), Exception);
+        corrupt(bytesAt, uint64_t(4));
+        EXPECT_THROW(WeightFileObj::open(runtime, path), Exception);
+        // An offset far past the end of the mapping.
+        corrupt(offsetAt, uint64_t(0) - WeightFileObj::dataAlignment);
+        EXPECT_THROW(WeightFileObj::open(runtime, path), Exception);
+        corrupt(offsetAt, uint64_t(0));
+        EXPECT_EQ(WeightFileObj::open(runtime, path)->getEntry("w").bytes, 24u);
+        std::remove(path.c_str());
+    }
+
+} // namespace infini
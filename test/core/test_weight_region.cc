@@ -0,0 +1,112 @@
+#include "core/graph.h"
+#include "core/runtime.h"
+#include "operators/element_wise.h"
+
+#include "test.h"
+
+namespace infini
+{
+    TEST(WeightRegion, ReplanKeepsWeights)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({1, 3}, DataType::Float32);
+        Tensor w = g->addTensor({3}, DataType::Float32);
+        Tensor b = g->addTensor({3}, DataType::Float32);
+        w->setWeight();
+        b->setWeight();
+        auto mul = g->addOp<MulObj>(x, w, nullptr);
+        auto add = g->addOp<AddObj>(mul->getOutput(), b, nullptr);
+        g->dataMalloc();
+
+        auto region = g->getWeightRegion();
+        ASSERT_NE(region, nullptr);
+        EXPECT_EQ(region->getNumEntries(), 2u);
+        // Only activations go through the planner.
+        for (const auto &interval : g->getMemoryPlan().intervals)
+            EXPECT_FALSE(interval.tensor->isWeight());
+        auto wPtr = w->getRawDataPtr<void *>();
+        EXPECT_EQ(wPtr, region->getPtr(w));
+        w->setData(IncrementalGenerator());
+        b->setData(OneGenerator());
+
+        // Re-plan for a larger batch.
+        x->setShape({4, 3});
+        g->shape_infer();
+        g->dataMalloc();
+        EXPECT_EQ(g->getWeightRegion(), region);
+        EXPECT_EQ(w->getRawDataPtr<void *>(), wPtr);
+        EXPECT_EQ(add->getOutput()->getDims(), (Shape{4, 3}));
+
+        x->setData(OneGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(add->getOutput()->equalData(
+            vector<float>{1, 2, 3, 1, 2, 3, 1, 2, 3, 1, 2, 3}));
+    }
+
+    TEST(WeightRegion, GrowsWithNewWeights)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g = make_ref<GraphObj>(runtime);
+        Tensor x = g->addTensor({1, 3}, DataType::Float32);
+        Tensor w = g->addTensor({3}, DataType::Float32);
+        w->setWeight();
+        auto mul = g->addOp<MulObj>(x, w, nullptr);
+        g->dataMalloc();
+        w->setData(IncrementalGenerator());
+
+        // A weight added after the region was laid out.
+        Tensor b = g->addTensor({3}, DataType::Float32);
+        b->setWeight();
+        auto add = g->addOp<AddObj>(mul->getOutput(), b, nullptr);
+        g->dataMalloc();
+        auto region = g->getWeightRegion();
+        EXPECT_EQ(region->getNumEntries(), 2u);
+        EXPECT_EQ(w->getRawDataPtr<void *>(), region->getPtr(w));
+        EXPECT_EQ(b->getRawDataPtr<void *>(), region->getPtr(b));
+        b->setData(OneGenerator());
+
+        x->setData(OneGenerator());
+        runtime->run(g);
+        EXPECT_TRUE(add->getOutput()->equalData(vector<float>{1, 2, 3}));
+    }
+
+    TEST(WeightRegion, SharedAcrossGraphs)
+    {
+        Runtime runtime = NativeCpuRuntimeObj::getInstance();
+        Graph g1 = make_ref<GraphObj>(runtime);
+        Tensor w = g1->addTensor({2}, DataType::Float32);
+        w->setWeight();
+        Tensor x1 = g1->addTensor({1, 2}, DataType::Float32);
+        g1->addOp<MulObj>(x1, w, nullptr);
+        g1->dataMalloc();
+        w->setData(IncrementalGenerator());
+
+        // A second batch bucket of the same model.
+        Graph g2 = make_ref<GraphObj>(runtime);
+        Tensor w2 = g2->addTensor(w->clone());
+        Tensor x2 = g2->addTensor({4, 2}, DataType::Float32);
+        auto mul2 = g2->addOp<MulObj>(x2, w2, nullptr);
+        g2->setWeightRegion(g1->getWeightRegion());
+        g2->dataMalloc();
+        EXPECT_EQ(w2->getRawDataPtr<void *>(), w->getRawDataPtr<void *>());
+
+        x2->setData(OneGenerator());
+        runtime->run(g2);
+        EXPECT_TRUE(
+            mul2->getOutput()->equalData(vector<float>{0, 1, 0, 1, 0, 1, 0, 1}));
+
+        // A weight only g2 has gets g2 its own region, keeping w's data.
+        Tensor b2 = g2->addTensor({2}, DataType::Float32);
+        b2->setWeight();
+        auto add2 = g2->addOp<AddObj>(mul2->getOutput(), b2, nullptr);
+        g2->dataMalloc();
+        EXPECT_NE(g2->getWeightRegion(), g1->getWeightRegion());
+        b2->setData(OneGenerator());
+        x2->setData(OneGenerator());
+        runtime->run(g2);
+        EXPECT_TRUE(
+            add2->getOutput()->equalData(vector<float>{1, 2, 1, 2, 1, 2, 1, 2}));
+    }
+
+} // namespace infini